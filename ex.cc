@@ -5,9 +5,39 @@
 #include "ns3/netanim-module.h"
 #include "ns3/network-module.h"
 #include "ns3/point-to-point-module.h"
+#include "ns3/traffic-control-module.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/ipv4-static-routing.h"
 
+#include "wan-anycast.h"
+#include "wan-bgp.h"
+#include "wan-dial-on-demand.h"
+#include "wan-dual-homed.h"
+#include "wan-failover-client.h"
+#include "wan-flow-export.h"
+#include "wan-forwarding-engine.h"
+#include "wan-fragmentation-stats.h"
+#include "wan-hierarchical-fib.h"
+#include "wan-htb.h"
+#include "wan-multicast-benchmark.h"
+#include "wan-multipath.h"
+#include "wan-optimizer.h"
+#include "wan-packet-train.h"
+#include "wan-partition.h"
+#include "wan-replication.h"
+#include "wan-scheduler.h"
+#include "wan-segment-routing.h"
+#include "wan-sweep.h"
+#include "wan-topology-generator.h"
+#include "wan-topology.h"
+#include "wan-vrf-routing.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("WANExtensionWithRedundancy");
@@ -30,11 +60,483 @@ DisableLink(Ptr<NetDevice> device)
     // will be dropped at the lower layer because the device is down.
     // The backup path should take effect in the forwarder after the primary
     // route fails to send.
+
+    // No interface goes down either, so BGP speakers without KEEPALIVEs are told
+    BgpRouter::SignalLinkSilent(device);
+}
+
+/**
+ * @brief Utility function to move multicast distribution off Link B.
+ * Before the failure DC (n2) sources the group on Link B and HQ (n0) forwards
+ * it to Branch (n1) over Link A. Afterwards DC sources on Link C and Branch
+ * forwards it to HQ over Link A.
+ *
+ * @param routingN0 Static routing of HQ (n0).
+ * @param routingN1 Static routing of Branch (n1).
+ * @param routingN2 Static routing of DC (n2).
+ * @param group Multicast group address.
+ */
+void
+MulticastFailover(Ptr<Ipv4StaticRouting> routingN0,
+                  Ptr<Ipv4StaticRouting> routingN1,
+                  Ptr<Ipv4StaticRouting> routingN2,
+                  Ipv4Address group)
+{
+    // DC: replace the default multicast route (224.0.0.0/4) on Link B by Link C
+    for (uint32_t i = 0; i < routingN2->GetNRoutes(); ++i)
+    {
+        Ipv4RoutingTableEntry route = routingN2->GetRoute(i);
+        if (route.GetDestNetwork() == Ipv4Address("224.0.0.0") && route.GetInterface() == 1)
+        {
+            routingN2->RemoveRoute(i);
+            break;
+        }
+    }
+    routingN2->SetDefaultMulticastRoute(2);
+
+    // HQ no longer receives the group on Link B; Branch now feeds it over Link A
+    routingN0->RemoveMulticastRoute(Ipv4Address::GetAny(), group, 2);
+    routingN1->AddMulticastRoute(Ipv4Address::GetAny(), group, 2, std::vector<uint32_t>{1});
+    NS_LOG_INFO("Multicast group " << group << " moved to Link C");
+}
+
+/**
+ * @brief Utility function to fail over a hierarchical FIB and time it.
+ * Only the next-hop groups using the device are rewritten, so the time does
+ * not depend on the number of prefixes behind the link.
+ *
+ * @param fib The FIB of the node owning the device.
+ * @param device The device that went down.
+ */
+void
+FibLinkDown(Ptr<Ipv4HierarchicalFib> fib, Ptr<NetDevice> device)
+{
+    auto begin = std::chrono::steady_clock::now();
+    uint32_t groups = fib->LinkDown(device);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "FIB failover on node " << device->GetNode()->GetId() << ": " << groups
+              << " group(s) switched for " << fib->GetNPrefixes() << " prefixes in "
+              << std::chrono::duration<double, std::micro>(end - begin).count() << " us\n";
+}
+
+/**
+ * @brief Utility function to mark a packet as belonging to a tenant VRF.
+ * Connected to an application's Tx trace; packet tags may be added to const packets.
+ *
+ * @param vrf Tenant VRF identifier.
+ * @param packet The packet being sent.
+ */
+void
+TagTenant(uint16_t vrf, Ptr<const Packet> packet)
+{
+    VrfTag tag;
+    tag.SetVrf(vrf);
+    packet->AddPacketTag(tag);
+}
+
+/**
+ * @brief Utility function to count a packet; connected to an application's Rx trace.
+ *
+ * @param count Counter.
+ * @param packet The packet.
+ */
+void
+CountPacket(uint64_t* count, Ptr<const Packet> packet)
+{
+    ++*count;
+}
+
+/**
+ * @brief Utility function to count tenant packets an IPv4 stack dropped for lack of a route.
+ *
+ * @param count Counter.
+ * @param header IPv4 header of the packet.
+ * @param packet The packet.
+ * @param reason Drop reason.
+ * @param ipv4 The IPv4 stack.
+ * @param interface Interface of the drop.
+ */
+void
+CountTenantDrop(uint64_t* count,
+                const Ipv4Header& header,
+                Ptr<const Packet> packet,
+                Ipv4L3Protocol::DropReason reason,
+                Ptr<Ipv4> ipv4,
+                uint32_t interface)
+{
+    VrfTag tag;
+    if (reason == Ipv4L3Protocol::DROP_NO_ROUTE && packet->PeekPacketTag(tag))
+    {
+        ++*count;
+    }
+}
+
+/**
+ * @brief Utility function to set the MTU on both ends of a point-to-point link.
+ *
+ * @param devices The two NetDevices of the link.
+ * @param mtu MTU in bytes (values above 1500 model jumbo frames).
+ */
+void
+SetLinkMtu(NetDeviceContainer devices, uint16_t mtu)
+{
+    for (uint32_t i = 0; i < devices.GetN(); ++i)
+    {
+        devices.Get(i)->SetMtu(mtu);
+    }
+}
+
+/**
+ * @brief Leaf classes of the HQ egress shaper on Link B.
+ */
+struct WanShapingClasses
+{
+    uint32_t dcInteractive{0};    //!< Echo traffic to DC
+    std::vector<uint32_t> dcBulk; //!< Other traffic to DC, one leaf per flow bucket
+    uint32_t otherInteractive{0}; //!< Echo traffic to other sites
+    uint32_t otherBulk{0};        //!< Other traffic to other sites
+};
+
+/**
+ * @brief Utility function to classify HQ egress traffic by site and class.
+ * DC is 10.1.2.0/24 and 10.1.3.0/24; UDP port 7 or 9 (echo) is interactive.
+ *
+ * @param classes Leaf classes of the shaper.
+ * @param item The packet to classify.
+ * @return The leaf class index.
+ */
+uint32_t
+ClassifyWanTraffic(const WanShapingClasses* classes, Ptr<const QueueDiscItem> item)
+{
+    Ptr<const Ipv4QueueDiscItem> ipItem = DynamicCast<const Ipv4QueueDiscItem>(item);
+    if (!ipItem)
+    {
+        return HtbQueueDisc::NONE;
+    }
+    const Ipv4Header& header = ipItem->GetHeader();
+    uint32_t dest = header.GetDestination().Get() & 0xffffff00;
+    bool dc = dest == Ipv4Address("10.1.2.0").Get() || dest == Ipv4Address("10.1.3.0").Get();
+    uint16_t sport = 0;
+    uint16_t dport = 0;
+    uint8_t ports[4];
+    if (header.GetFragmentOffset() == 0 && item->GetPacket()->GetSize() >= 4)
+    {
+        item->GetPacket()->CopyData(ports, 4);
+        sport = uint16_t(ports[0] << 8 | ports[1]);
+        dport = uint16_t(ports[2] << 8 | ports[3]);
+    }
+    bool echo = header.GetProtocol() == UdpL4Protocol::PROT_NUMBER &&
+                (sport == 7 || sport == 9 || dport == 7 || dport == 9);
+    if (!dc)
+    {
+        return echo ? classes->otherInteractive : classes->otherBulk;
+    }
+    if (echo)
+    {
+        return classes->dcInteractive;
+    }
+    return classes->dcBulk[(sport * 31u + dport) % classes->dcBulk.size()];
 }
 
 int
 main(int argc, char* argv[])
 {
+    // Command line parameters
+    uint32_t packetSize = 1024;       // Echo payload; above the MTU it is fragmented
+    uint16_t mtuLinkA = 1500;         // HQ <-> Branch
+    uint16_t mtuLinkB = 1500;         // HQ <-> DC
+    uint16_t mtuLinkC = 1500;         // Branch <-> DC
+    uint16_t tunnelOverhead = 0;      // Encapsulation bytes on the backup path (Link A + C)
+    double fragmentTimeout = 30.0;    // Reassembly timeout in seconds
+    bool dedup = false;               // WAN optimizer on Link C (Branch <-> DC)
+    uint32_t dedupCacheKb = 4096;     // Chunk store size per direction
+    uint32_t dedupChunk = 256;        // Average content-defined chunk size
+    bool multicast = false;           // DC -> all sites multicast distribution
+    uint32_t multicastBench = 0;      // Receivers in the replication benchmark (0 = off)
+    bool anycast = false;             // Echo service on DC-East (n2) and DC-West (n3)
+    uint32_t tenants = 0;             // Tenant VRFs per router (0 = global table only)
+    uint32_t echoTenant = 0;          // VRF the echo client's traffic is tagged with (0 = none)
+    bool echoTenantNoRoute = false;   // Echo tenant has no routes on HQ (isolation check)
+    bool fib = false;                 // Primary/backup via shared next-hop groups
+    uint32_t fibPrefixes = 0;         // Extra /24 prefixes behind each next-hop group
+    bool sr = false;                  // Segment routing with TI-LFA between HQ and DC
+    std::string srPath = "2";         // Node segments HQ -> DC (e.g. "1,2" via Branch)
+    uint32_t srThreads = 0;           // Threads for the TI-LFA computation (0 = all cores)
+    bool bgp = false;                 // BGP instead of the static primary/backup routes
+    bool idleFastForward = false;     // No BGP KEEPALIVEs on idle sessions
+    std::string transfer = "none";    // Bulk TCP HQ -> DC: none, single or multipath
+    uint32_t transferMb = 8;          // Size of the bulk transfer in MB
+    uint32_t failoverClients = 0;     // Echo clients failing over between DC addresses
+    uint32_t flowSampling = 0;        // NetFlow export, 1-in-N sampling (0 = off)
+    uint32_t flowCache = 4096;        // Flow cache entries per router
+    double branchPps = 0;             // Branch forwarding capacity (0 = unlimited)
+    uint32_t branchQueue = 100;       // Branch ingress queue in packets
+    double reconvergenceCpu = 0.5;    // Branch CPU share taken by the control plane at failover
+    bool htb = false;                 // Hierarchical shaping of HQ's egress onto Link B
+    uint32_t htbFlows = 4;            // Bulk leaves under the DC site class
+    bool dialBackup = false;          // Links A and C dormant until Link B fails
+    double dialDelay = 2.0;           // Seconds to bring the dial-on-demand links up
+    uint32_t dualHomed = 0;           // Branches in the dual-homed two-DC scenario (0 = off)
+    uint32_t failDc = 0;              // DC failed in the dual-homed scenario (0 or 1)
+    std::string topology;             // WAN graph file to import and run instead (empty = off)
+    std::string topologyFormat;       // edgelist, graphml or gml (empty = by file extension)
+    bool topologyFailover = true;     // Route and fail a link on the imported or generated graph
+    std::string generate;             // Synthetic graph: waxman, ba, dualhub or mesh (empty = off)
+    uint32_t generateNodes = 1000;    // Nodes of the synthetic graph
+    double generateDegree = 4;        // Mean degree of the synthetic graph
+    uint64_t generateSeed = 1;        // Seed of the synthetic graph
+    uint32_t partitions = 0;          // Partition the imported or generated graph for N cores
+    uint32_t replications = 0;        // Failover replications on one built graph (0 = single run)
+    bool fastTeardown = false;        // Exit after the graph reports instead of Simulator::Destroy
+    bool packetTrains = false;        // Deliver Link A/B/C arrivals as packet trains
+    double trainWindowUs = 0;         // Extra wait to merge arrivals, in us (0 = exact timing)
+    std::string sweep;                // Variants to run concurrently: flag=v1,v2,... (empty = off)
+    uint32_t sweepWorkers = 0;        // Concurrent sweep variants (0 = all cores)
+    std::string scheduler;            // Event scheduler: map, heap or batch (empty = default)
+    uint64_t schedulerBench = 0;      // Events in the scheduler benchmark (0 = off)
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("packetSize", "Echo payload size in bytes", packetSize);
+    cmd.AddValue("mtuLinkA", "MTU of Link A (HQ-Branch)", mtuLinkA);
+    cmd.AddValue("mtuLinkB", "MTU of Link B (HQ-DC)", mtuLinkB);
+    cmd.AddValue("mtuLinkC", "MTU of Link C (Branch-DC)", mtuLinkC);
+    cmd.AddValue("tunnelOverhead",
+                 "Tunnel header bytes subtracted from the MTU of the backup path",
+                 tunnelOverhead);
+    cmd.AddValue("fragmentTimeout", "IPv4 reassembly timeout in seconds", fragmentTimeout);
+    cmd.AddValue("dedup", "Enable the WAN optimizer on Link C (Branch-DC)", dedup);
+    cmd.AddValue("dedupCacheKb", "WAN optimizer chunk store size in KiB", dedupCacheKb);
+    cmd.AddValue("dedupChunk", "WAN optimizer average chunk size in bytes", dedupChunk);
+    cmd.AddValue("multicast", "Send a multicast stream from DC to HQ and Branch", multicast);
+    cmd.AddValue("multicastBench",
+                 "Run only the multicast replication benchmark with this many receivers",
+                 multicastBench);
+    cmd.AddValue("anycast",
+                 "Serve echo from DC-East and DC-West under one anycast address",
+                 anycast);
+    cmd.AddValue("tenants", "Number of tenant VRFs on every router", tenants);
+    cmd.AddValue("echoTenant", "Tenant VRF (1..tenants) carrying the echo traffic", echoTenant);
+    cmd.AddValue("echoTenantNoRoute",
+                 "Leave the echo tenant without routes on HQ to show its traffic is dropped",
+                 echoTenantNoRoute);
+    cmd.AddValue("fib", "Route HQ<->DC through hierarchical FIBs with next-hop groups", fib);
+    cmd.AddValue("fibPrefixes", "Additional prefixes sharing each next-hop group", fibPrefixes);
+    cmd.AddValue("sr", "Forward HQ<->DC traffic with segment routing and TI-LFA", sr);
+    cmd.AddValue("srPath", "Comma-separated node segments from HQ to DC", srPath);
+    cmd.AddValue("srThreads", "Threads for the TI-LFA computation (0 = all cores)", srThreads);
+    cmd.AddValue("bgp", "Replace the static routes by BGP (AS65000 HQ+Branch, AS65100 DC)", bgp);
+    cmd.AddValue("idleFastForward",
+                 "Skip BGP KEEPALIVEs on idle sessions until a link event",
+                 idleFastForward);
+    cmd.AddValue("transfer",
+                 "Bulk TCP transfer HQ->DC: none, single (Link B) or multipath (Link B + A/C)",
+                 transfer);
+    cmd.AddValue("transferMb", "Size of the bulk transfer in MB", transferMb);
+    cmd.AddValue("failoverClients",
+                 "HQ echo clients failing over between 10.1.2.2 and 10.1.3.2 (0 = off)",
+                 failoverClients);
+    cmd.AddValue("flowSampling", "Export sampled flows, one packet in N (0 = off)", flowSampling);
+    cmd.AddValue("flowCache", "Flow cache entries per router", flowCache);
+    cmd.AddValue("branchPps",
+                 "Branch forwarding capacity in packets/s (0 = unlimited)",
+                 branchPps);
+    cmd.AddValue("branchQueue", "Branch ingress queue in packets", branchQueue);
+    cmd.AddValue("reconvergenceCpu",
+                 "Branch CPU share used by the control plane for 1 s after the failure",
+                 reconvergenceCpu);
+    cmd.AddValue("htb", "Shape HQ's egress onto Link B per site and class", htb);
+    cmd.AddValue("htbFlows", "Per-flow bulk leaf classes under the DC site", htbFlows);
+    cmd.AddValue("dialBackup", "Keep Links A and C dormant until Link B fails", dialBackup);
+    cmd.AddValue("dialDelay",
+                 "Activation delay of the dial-on-demand links in seconds",
+                 dialDelay);
+    cmd.AddValue("dualHomed",
+                 "Run only the dual-homed scenario with this many branches and two DCs",
+                 dualHomed);
+    cmd.AddValue("failDc", "DC (0 or 1) failed at 4 s in the dual-homed scenario", failDc);
+    cmd.AddValue("topology",
+                 "Run only the failover experiment on a graph read from this file",
+                 topology);
+    cmd.AddValue("topologyFormat",
+                 "Format of the topology file: edgelist, graphml or gml (default: by extension)",
+                 topologyFormat);
+    cmd.AddValue("topologyFailover",
+                 "Route and fail a link on the imported or generated graph (false = build only)",
+                 topologyFailover);
+    cmd.AddValue("generate",
+                 "Run only the failover experiment on a waxman, ba, dualhub or mesh graph",
+                 generate);
+    cmd.AddValue("generateNodes", "Nodes of the synthetic graph", generateNodes);
+    cmd.AddValue("generateDegree", "Mean degree of the synthetic graph", generateDegree);
+    cmd.AddValue("generateSeed", "Seed of the synthetic graph", generateSeed);
+    cmd.AddValue("partitions",
+                 "Partition the imported or generated graph for this many cores (0 = off)",
+                 partitions);
+    cmd.AddValue("replications",
+                 "Failover replications reusing one built graph, reset between runs (0 = off)",
+                 replications);
+    cmd.AddValue("fastTeardown",
+                 "Release an imported or generated graph in bulk at exit, not object by object",
+                 fastTeardown);
+    cmd.AddValue("packetTrains", "Deliver Link A/B/C arrivals as packet trains", packetTrains);
+    cmd.AddValue("trainWindowUs",
+                 "Extra wait in us to merge arrivals into one event (0 = exact timing, "
+                 "one event per packet)",
+                 trainWindowUs);
+    cmd.AddValue("sweep",
+                 "Run one variant per value of a flag, concurrently: name=value1,value2,...",
+                 sweep);
+    cmd.AddValue("sweepWorkers", "Sweep variants run at once (0 = all cores)", sweepWorkers);
+    cmd.AddValue("scheduler",
+                 "Event scheduler: map, heap or batch (same-timestamp batches)",
+                 scheduler);
+    cmd.AddValue("schedulerBench",
+                 "Compare scheduler event rates on N same-timestamp events (0 = off)",
+                 schedulerBench);
+    cmd.Parse(argc, argv);
+
+    // Trace files; sweep variants run at the same time, so each gets its own
+    std::string outputPrefix = "scratch/exercise1-redundant-wan";
+    if (!sweep.empty())
+    {
+        size_t equals = sweep.find('=');
+        NS_ABORT_MSG_IF(equals == std::string::npos, "sweep must be name=value1,value2,...");
+        std::string name = sweep.substr(0, equals);
+        std::vector<std::string> values;
+        std::istringstream list(sweep.substr(equals + 1));
+        std::string value;
+        while (std::getline(list, value, ','))
+        {
+            values.push_back(value);
+        }
+        ScenarioSweep runner;
+        int variant = runner.Fork(values.size(), sweepWorkers);
+        if (variant < 0)
+        {
+            for (uint32_t i = 0; i < values.size(); ++i)
+            {
+                std::cout << "=== Sweep " << name << "=" << values[i] << " ===\n"
+                          << runner.GetOutput(i);
+                if (runner.GetStatus(i) != 0)
+                {
+                    std::cout << "(exit status " << runner.GetStatus(i) << ")\n";
+                }
+            }
+            return 0;
+        }
+        // Only the swept flag is parsed again; everything else keeps the shared values
+        std::string argument = "--" + name + "=" + values[variant];
+        char* arguments[] = {argv[0], argument.data()};
+        cmd.Parse(2, arguments);
+        outputPrefix += "-sweep" + std::to_string(variant);
+    }
+
+    NS_ABORT_MSG_IF(dedupChunk < 64, "dedupChunk must be at least 64 bytes");
+    NS_ABORT_MSG_IF(tenants > 65534, "tenants must be at most 65534 (0xffff means no VRF)");
+    NS_ABORT_MSG_IF(echoTenant > tenants, "echoTenant must be one of the configured tenants");
+    NS_ABORT_MSG_IF(echoTenantNoRoute && echoTenant == 0, "echoTenantNoRoute needs echoTenant");
+    NS_ABORT_MSG_IF(htb && htbFlows == 0, "htbFlows must be at least 1");
+    NS_ABORT_MSG_IF(transfer != "none" && transfer != "single" && transfer != "multipath",
+                    "transfer must be none, single or multipath");
+
+    if (schedulerBench > 0)
+    {
+        RunSchedulerBenchmark(schedulerBench, 1000, std::cout);
+        return 0;
+    }
+
+    if (!scheduler.empty())
+    {
+        ObjectFactory schedulerFactory;
+        if (scheduler == "map")
+        {
+            schedulerFactory.SetTypeId(MapScheduler::GetTypeId());
+        }
+        else if (scheduler == "heap")
+        {
+            schedulerFactory.SetTypeId(HeapScheduler::GetTypeId());
+        }
+        else
+        {
+            NS_ABORT_MSG_IF(scheduler != "batch", "scheduler must be map, heap or batch");
+            schedulerFactory.SetTypeId(SameTimeBatchScheduler::GetTypeId());
+        }
+        Simulator::SetScheduler(schedulerFactory);
+    }
+
+    if (multicastBench > 0)
+    {
+        RunMulticastReplicationBenchmark(multicastBench, 100, packetSize, std::cout);
+        return 0;
+    }
+
+    if (dualHomed > 0)
+    {
+        NS_ABORT_MSG_IF(failDc > 1, "failDc must be 0 or 1");
+        RunDualHomedScenario(dualHomed, failDc, std::cout);
+        return 0;
+    }
+
+    if (!topology.empty() || !generate.empty())
+    {
+        WanGraph graph;
+        auto graphStart = std::chrono::steady_clock::now();
+        if (!topology.empty())
+        {
+            WanGraphReader reader(DataRate("1Gbps").GetBitRate(), MilliSeconds(5));
+            NS_ABORT_MSG_IF(!reader.Read(topology, topologyFormat, graph),
+                            "Cannot read topology " << topology << " as " << topologyFormat);
+            std::cout << "=== Imported Topology ===\n" << "Read " << topology;
+        }
+        else
+        {
+            WanGraphGenerator generator(generateSeed,
+                                        DataRate("1Gbps").GetBitRate(),
+                                        MilliSeconds(5));
+            NS_ABORT_MSG_IF(!generator.Generate(generate, generateNodes, generateDegree, graph),
+                            "generate must be waxman, ba, dualhub or mesh");
+            std::cout << "=== Generated Topology ===\n" << generate << " seed " << generateSeed;
+        }
+        std::cout << " in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                               graphStart)
+                         .count()
+                  << " ms\n";
+        if (partitions > 0)
+        {
+            // About 250 packets/s per link direction; 1 us per event, 10 us per barrier
+            WanPartitioner partitioner(1000, MicroSeconds(1), MicroSeconds(10));
+            std::cout << "=== Partitioning ===\n";
+            partitioner.Partition(graph, partitions).Print(std::cout, graph.edges.size());
+        }
+        if (replications > 0)
+        {
+            std::cout << "=== Replications ===\n";
+            RunWanGraphReplications(graph, replications, std::cout);
+        }
+        else
+        {
+            RunWanGraphScenario(graph, topologyFailover, std::cout);
+        }
+        if (fastTeardown)
+        {
+            ExitWithoutTeardown(0);
+        }
+        auto teardownStart = std::chrono::steady_clock::now();
+        Simulator::Destroy();
+        std::cout << "Teardown: "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                               teardownStart)
+                         .count()
+                  << " ms\n";
+        return 0;
+    }
+
+    NS_ABORT_MSG_IF(tunnelOverhead >= mtuLinkA || tunnelOverhead >= mtuLinkC,
+                    "Tunnel overhead must be smaller than the backup link MTU");
+    Config::SetDefault("ns3::Ipv4L3Protocol::FragmentExpirationTimeout",
+                       TimeValue(Seconds(fragmentTimeout)));
+
     // Set up logging
     LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
     LogComponentEnable("UdpEchoServerApplication", LOG_LEVEL_INFO);
@@ -84,6 +586,22 @@ main(int argc, char* argv[])
     Ipv4InterfaceContainer interfacesBranchDC = addressBranchDC.Assign(linkBranchDCDevices);
     // n1: 10.1.3.1, n2: 10.1.3.2
 
+    // Per-link MTUs; the backup path also loses the tunnel header bytes
+    SetLinkMtu(linkHQBranchDevices, mtuLinkA - tunnelOverhead);
+    SetLinkMtu(linkHQDCDevices, mtuLinkB);
+    SetLinkMtu(linkBranchDCDevices, mtuLinkC - tunnelOverhead);
+
+    // Packet-train channels on Links A, B and C
+    std::vector<Ptr<PointToPointTrainChannel>> trainChannels;
+    if (packetTrains)
+    {
+        for (const NetDeviceContainer& link :
+             {linkHQBranchDevices, linkHQDCDevices, linkBranchDCDevices})
+        {
+            trainChannels.push_back(UsePacketTrains(link, Seconds(trainWindowUs / 1e6)));
+        }
+    }
+
     // Set all nodes as routers to enable IP forwarding
     for (uint32_t i = 0; i < nodes.GetN(); ++i)
     {
@@ -169,7 +687,192 @@ main(int argc, char* argv[])
         2,                                  // Output interface index (Branch-DC Link)
         20                                  // Metric (Backup)
     );
+
+    // --- BGP: replaces the static primary/backup routes above ---
+
+    std::vector<Ptr<BgpRouter>> bgpRouters;
+    if (bgp)
+    {
+        // Only the connected routes stay in the static tables
+        for (Ptr<Ipv4StaticRouting> routing : {staticRoutingN0, staticRoutingN1, staticRoutingN2})
+        {
+            for (uint32_t i = routing->GetNRoutes(); i-- > 0;)
+            {
+                if (routing->GetRoute(i).GetGateway() != Ipv4Address::GetZero())
+                {
+                    routing->RemoveRoute(i);
+                }
+            }
+        }
+
+        Config::SetDefault("ns3::BgpRouter::IdleFastForward", BooleanValue(idleFastForward));
+
+        // AS65000: HQ reflects routes to its client Branch over Link A
+        Ptr<BgpRouter> bgpN0 = InstallBgp(n0, 65000, Ipv4Address("10.1.1.1"));
+        bgpN0->AddPeer(1, Ipv4Address("10.1.1.2"), 65000, true);
+        // Link B is the primary exit towards DC: raise its LOCAL_PREF
+        bgpN0->AddPeer(2, Ipv4Address("10.1.2.2"), 65100, false, 200);
+        bgpN0->Originate(Ipv4Address("10.1.1.0"), Ipv4Mask("255.255.255.0"));
+        bgpN0->Originate(Ipv4Address("10.1.2.0"), Ipv4Mask("255.255.255.0"));
+
+        Ptr<BgpRouter> bgpN1 = InstallBgp(n1, 65000, Ipv4Address("10.1.1.2"));
+        bgpN1->AddPeer(1, Ipv4Address("10.1.1.1"), 65000);
+        bgpN1->AddPeer(2, Ipv4Address("10.1.3.2"), 65100);
+        bgpN1->Originate(Ipv4Address("10.1.1.0"), Ipv4Mask("255.255.255.0"));
+        bgpN1->Originate(Ipv4Address("10.1.3.0"), Ipv4Mask("255.255.255.0"));
+
+        // AS65100: DC peers with both HQ (Link B) and Branch (Link C)
+        Ptr<BgpRouter> bgpN2 = InstallBgp(n2, 65100, Ipv4Address("10.1.2.2"));
+        bgpN2->AddPeer(1, Ipv4Address("10.1.2.1"), 65000);
+        bgpN2->AddPeer(2, Ipv4Address("10.1.3.1"), 65000);
+        bgpN2->Originate(Ipv4Address("10.1.2.0"), Ipv4Mask("255.255.255.0"));
+        bgpN2->Originate(Ipv4Address("10.1.3.0"), Ipv4Mask("255.255.255.0"));
+
+        bgpRouters = {bgpN0, bgpN1, bgpN2};
+    }
+
+    // --- Tenant VRFs: every tenant starts from the global primary/backup design ---
+
+    std::vector<Ptr<Ipv4VrfRouting>> vrfRouting;
+    if (tenants > 0)
+    {
+        for (uint32_t i = 0; i < nodes.GetN(); ++i)
+        {
+            Ptr<Ipv4VrfRouting> vrf = InstallVrfRouting(nodes.Get(i));
+            // Identical tables are interned, so all tenants share one copy per router
+            Ptr<Ipv4StaticRouting> routing =
+                staticRoutingHelper.GetStaticRouting(nodes.Get(i)->GetObject<Ipv4>());
+            VrfTable::Handle table = SnapshotStaticRoutes(routing);
+            for (uint32_t t = 1; t <= tenants; ++t)
+            {
+                vrf->SetTable(t, table);
+            }
+            vrfRouting.push_back(vrf);
+        }
+    }
+    uint64_t tenantDrops = 0;
+    if (echoTenantNoRoute)
+    {
+        // The global table still reaches DC; the tenant must not use it
+        vrfRouting[0]->SetTable(echoTenant, nullptr);
+        n0->GetObject<Ipv4L3Protocol>()->TraceConnectWithoutContext(
+            "Drop",
+            MakeBoundCallback(&CountTenantDrop, &tenantDrops));
+    }
+
+    // --- Hierarchical FIB: prefixes share one primary/backup next-hop group ---
+
+    Ptr<Ipv4HierarchicalFib> fibN0;
+    Ptr<Ipv4HierarchicalFib> fibN2;
+    if (fib)
+    {
+        // The groups replace the static HQ<->DC primary/backup pairs on n0 and n2
+        std::pair<Ptr<Ipv4StaticRouting>, Ipv4Address> pairs[] = {
+            {staticRoutingN0, Ipv4Address("10.1.3.0")},
+            {staticRoutingN2, Ipv4Address("10.1.1.0")}};
+        for (const auto& [routing, dest] : pairs)
+        {
+            for (uint32_t i = routing->GetNRoutes(); i-- > 0;)
+            {
+                Ipv4RoutingTableEntry route = routing->GetRoute(i);
+                if (route.GetDestNetwork() == dest && route.GetGateway() != Ipv4Address::GetZero())
+                {
+                    routing->RemoveRoute(i);
+                }
+            }
+        }
+
+        // HQ -> DC: Link B (interface 2) first, Branch over Link A (interface 1) as backup
+        fibN0 = InstallHierarchicalFib(n0);
+        uint32_t toDC = fibN0->CreateGroup();
+        fibN0->AddGroupMember(toDC, Ipv4Address("10.1.2.2"), 2, 10);
+        fibN0->AddGroupMember(toDC, Ipv4Address("10.1.1.2"), 1, 20);
+        fibN0->AddPrefix(Ipv4Address("10.1.3.0"), Ipv4Mask("255.255.255.0"), toDC);
+
+        // DC -> HQ: Link B (interface 1) first, Branch over Link C (interface 2) as backup
+        fibN2 = InstallHierarchicalFib(n2);
+        uint32_t toHQ = fibN2->CreateGroup();
+        fibN2->AddGroupMember(toHQ, Ipv4Address("10.1.2.1"), 1, 10);
+        fibN2->AddGroupMember(toHQ, Ipv4Address("10.1.3.1"), 2, 20);
+        fibN2->AddPrefix(Ipv4Address("10.1.1.0"), Ipv4Mask("255.255.255.0"), toHQ);
+
+        // Synthetic prefixes (20.0.0.0/24 upwards) behind the same groups
+        for (uint32_t i = 0; i < fibPrefixes; ++i)
+        {
+            Ipv4Address prefix(Ipv4Address("20.0.0.0").Get() + (i << 8));
+            fibN0->AddPrefix(prefix, Ipv4Mask("255.255.255.0"), toDC);
+            fibN2->AddPrefix(prefix, Ipv4Mask("255.255.255.0"), toHQ);
+        }
+    }
+
+    // --- Segment Routing: explicit paths with TI-LFA protection ---
+
+    Ptr<SrDomain> srDomain;
+    if (sr)
+    {
+        srDomain = InstallSegmentRouting(nodes, srThreads, std::cout);
+        std::vector<uint32_t> path;
+        std::istringstream segments(srPath);
+        std::string segment;
+        while (std::getline(segments, segment, ','))
+        {
+            char* end = nullptr;
+            unsigned long sid = std::strtoul(segment.c_str(), &end, 10);
+            NS_ABORT_MSG_IF(segment.empty() || *end != '\0' || sid >= nodes.GetN(),
+                            "srPath must be comma-separated node indices, got " << srPath);
+            path.push_back(sid);
+        }
+        // HQ steers DC-bound traffic; DC returns to HQ on its shortest path
+        srDomain->AddPolicy(0, Ipv4Address("10.1.3.0"), Ipv4Mask("255.255.255.0"), path);
+        srDomain->AddPolicy(2, Ipv4Address("10.1.1.0"), Ipv4Mask("255.255.255.0"), {0});
+    }
     
+    // --- Branch Forwarding Capacity ---
+
+    Ptr<Ipv4ForwardingEngine> branchEngine;
+    if (branchPps > 0)
+    {
+        branchEngine = InstallForwardingEngine(n1, branchPps, branchQueue);
+    }
+
+    // --- Dial-on-Demand Backup: Links A and C ---
+
+    // Setup charge 1.00 and 0.10 per started minute for each link
+    DialOnDemandBackup dialOnDemand(Seconds(dialDelay), 1.0, 0.1);
+    if (dialBackup)
+    {
+        dialOnDemand.AddLink(linkHQBranchDevices);
+        dialOnDemand.AddLink(linkBranchDCDevices);
+        // The static routes over Links A and C on n0, n1 and n2 come back on activation
+    }
+
+    // --- HQ Egress Shaping on Link B (5 Mbps) ---
+
+    Ptr<HtbQueueDisc> hqShaper;
+    WanShapingClasses shapingClasses;
+    if (htb)
+    {
+        hqShaper = InstallHtb(linkHQDCDevices.Get(0));
+        uint32_t root =
+            hqShaper->AddClass(HtbQueueDisc::NONE, DataRate("5Mbps"), DataRate("5Mbps"));
+        uint32_t dcSite = hqShaper->AddClass(root, DataRate("4Mbps"), DataRate("5Mbps"));
+        uint32_t otherSite = hqShaper->AddClass(root, DataRate("1Mbps"), DataRate("5Mbps"));
+        shapingClasses.dcInteractive =
+            hqShaper->AddClass(dcSite, DataRate("1Mbps"), DataRate("4Mbps"), 0);
+        uint32_t dcBulk = hqShaper->AddClass(dcSite, DataRate("3Mbps"), DataRate("5Mbps"), 1);
+        for (uint32_t i = 0; i < htbFlows; ++i)
+        {
+            shapingClasses.dcBulk.push_back(
+                hqShaper->AddClass(dcBulk, DataRate(3000000 / htbFlows), DataRate("5Mbps")));
+        }
+        shapingClasses.otherInteractive =
+            hqShaper->AddClass(otherSite, DataRate("500kbps"), DataRate("1Mbps"), 0);
+        shapingClasses.otherBulk =
+            hqShaper->AddClass(otherSite, DataRate("500kbps"), DataRate("5Mbps"), 1);
+        hqShaper->SetDefaultClass(shapingClasses.otherBulk);
+        hqShaper->SetClassifier(MakeBoundCallback(&ClassifyWanTraffic, &shapingClasses));
+    }
+
     // --- Q3: Path Failure Simulation ---
     
     // Get the NetDevice for the primary HQ-DC link on the HQ side (n0)
@@ -182,6 +885,39 @@ main(int argc, char* argv[])
     Ptr<NetDevice> n2_HQDC_Device = linkHQDCDevices.Get(1);
     Simulator::Schedule(Seconds(4.0), &DisableLink, n2_HQDC_Device);
 
+    if (sr)
+    {
+        Simulator::Schedule(Seconds(4.0), &SrDomain::LinkDown, srDomain, n0_HQDC_Device);
+        Simulator::Schedule(Seconds(4.0), &SrDomain::LinkDown, srDomain, n2_HQDC_Device);
+    }
+
+    if (dialBackup)
+    {
+        Simulator::Schedule(Seconds(4.0),
+                            &DialOnDemandBackup::PrimaryDown,
+                            &dialOnDemand,
+                            linkHQDCDevices);
+    }
+
+    if (branchEngine)
+    {
+        // Reconvergence keeps Branch's CPU busy while the failover traffic arrives
+        Simulator::Schedule(Seconds(4.0),
+                            &Ipv4ForwardingEngine::SetControlPlaneShare,
+                            branchEngine,
+                            reconvergenceCpu);
+        Simulator::Schedule(Seconds(5.0),
+                            &Ipv4ForwardingEngine::SetControlPlaneShare,
+                            branchEngine,
+                            0.0);
+    }
+
+    if (fib)
+    {
+        Simulator::Schedule(Seconds(4.0), &FibLinkDown, fibN0, n0_HQDC_Device);
+        Simulator::Schedule(Seconds(4.0), &FibLinkDown, fibN2, n2_HQDC_Device);
+    }
+
     // --- Application Setup: Traffic from HQ (n0) to DC (n2) ---
 
     // Server on DC (n2)
@@ -190,6 +926,10 @@ main(int argc, char* argv[])
     ApplicationContainer serverApps = echoServer.Install(n2);
     serverApps.Start(Seconds(1.0));
     serverApps.Stop(Seconds(15.0));
+    uint64_t echoRequestsServed = 0;
+    serverApps.Get(0)->TraceConnectWithoutContext(
+        "Rx",
+        MakeBoundCallback(&CountPacket, &echoRequestsServed));
 
     // Client on HQ (n0) targeting DC's IP on the Branch-DC link network (10.1.3.2)
     // The destination IP must be in the network we want to test the route to: 10.1.3.0/24
@@ -198,11 +938,171 @@ main(int argc, char* argv[])
     UdpEchoClientHelper echoClient(dc_address_on_branch_link, port);
     echoClient.SetAttribute("MaxPackets", UintegerValue(10));
     echoClient.SetAttribute("Interval", TimeValue(Seconds(1.0)));
-    echoClient.SetAttribute("PacketSize", UintegerValue(1024));
+    echoClient.SetAttribute("PacketSize", UintegerValue(packetSize));
 
     ApplicationContainer clientApps = echoClient.Install(n0);
     clientApps.Start(Seconds(2.0)); // Start before failure
     clientApps.Stop(Seconds(15.0));
+    if (echoTenant > 0)
+    {
+        clientApps.Get(0)->TraceConnectWithoutContext(
+            "Tx",
+            MakeBoundCallback(&TagTenant, uint16_t(echoTenant)));
+    }
+
+    // --- Multicast Distribution: DC (n2) -> HQ (n0) and Branch (n1) ---
+
+    Ipv4Address multicastGroup("225.1.2.4");
+    uint16_t multicastPort = 9000;
+    ApplicationContainer multicastSinks;
+    if (multicast)
+    {
+        // DC sources the group on Link B (n2 interface 1)
+        staticRoutingHelper.SetDefaultMulticastRoute(n2, linkHQDCDevices.Get(1));
+        // HQ receives it on Link B (interface 2) and replicates onto Link A (interface 1)
+        staticRoutingN0->AddMulticastRoute(Ipv4Address::GetAny(),
+                                           multicastGroup,
+                                           2,
+                                           std::vector<uint32_t>{1});
+        Simulator::Schedule(Seconds(4.0),
+                            &MulticastFailover,
+                            staticRoutingN0,
+                            staticRoutingN1,
+                            staticRoutingN2,
+                            multicastGroup);
+
+        PacketSinkHelper multicastSink("ns3::UdpSocketFactory",
+                                       InetSocketAddress(Ipv4Address::GetAny(), multicastPort));
+        multicastSinks = multicastSink.Install(NodeContainer(n0, n1));
+        multicastSinks.Start(Seconds(1.0));
+        multicastSinks.Stop(Seconds(15.0));
+
+        UdpClientHelper multicastSource(multicastGroup, multicastPort);
+        multicastSource.SetAttribute("MaxPackets", UintegerValue(100));
+        multicastSource.SetAttribute("Interval", TimeValue(MilliSeconds(100)));
+        multicastSource.SetAttribute("PacketSize", UintegerValue(packetSize));
+        ApplicationContainer multicastSourceApps = multicastSource.Install(n2);
+        multicastSourceApps.Start(Seconds(2.0));
+        multicastSourceApps.Stop(Seconds(15.0));
+    }
+
+    // --- Anycast Service: DC-East (n2) and DC-West (n3) ---
+
+    Ipv4Address anycastAddress("10.99.0.1");
+    uint16_t anycastPort = 7;
+    AnycastService anycastService(anycastAddress);
+    NodeContainer dcWest;
+    if (anycast)
+    {
+        // DC-West (n3) hangs off Branch (n1) over Link D
+        dcWest.Create(1);
+        Ptr<Node> n3 = dcWest.Get(0);
+        stack.Install(dcWest);
+        Ipv4AddressHelper addressBranchDCWest; // Network 4: Branch <-> DC-West
+        addressBranchDCWest.SetBase("10.1.4.0", "255.255.255.0");
+        NetDeviceContainer linkBranchDCWestDevices = p2p.Install(n1, n3);
+        addressBranchDCWest.Assign(linkBranchDCWestDevices);
+        // n1: 10.1.4.1 (interface 3), n3: 10.1.4.2 (interface 1)
+
+        // DC-West sends all return traffic through Branch
+        staticRoutingHelper.GetStaticRouting(n3->GetObject<Ipv4>())
+            ->SetDefaultRoute(Ipv4Address("10.1.4.1"), 1);
+
+        Ptr<AnycastEchoServer> east = anycastService.AddReplica(n2, "DC-East (n2)", anycastPort);
+        Ptr<AnycastEchoServer> west = anycastService.AddReplica(n3, "DC-West (n3)", anycastPort);
+        for (Ptr<AnycastEchoServer> server : {east, west})
+        {
+            server->SetStartTime(Seconds(1.0));
+            server->SetStopTime(Seconds(15.0));
+        }
+
+        // HQ: DC-East is one hop over Link B, DC-West two hops through Branch
+        anycastService.AddPath(n0, Ipv4Address("10.1.2.2"), 2, 10, 0);
+        anycastService.AddPath(n0, Ipv4Address("10.1.1.2"), 1, 20, 1);
+        // Branch: DC-West over Link D, DC-East over Link C as backup
+        anycastService.AddPath(n1, Ipv4Address("10.1.4.2"), 3, 10, 1);
+        anycastService.AddPath(n1, Ipv4Address("10.1.3.2"), 2, 20, 0);
+
+        // Link B failure moves HQ's clients to DC-West
+        Simulator::Schedule(Seconds(4.0),
+                            &AnycastService::LinkDown,
+                            &anycastService,
+                            n0_HQDC_Device);
+
+        UdpEchoClientHelper anycastClient(anycastAddress, anycastPort);
+        anycastClient.SetAttribute("MaxPackets", UintegerValue(100));
+        anycastClient.SetAttribute("Interval", TimeValue(MilliSeconds(100)));
+        anycastClient.SetAttribute("PacketSize", UintegerValue(packetSize));
+        ApplicationContainer anycastClientApps = anycastClient.Install(NodeContainer(n0, n1));
+        anycastClientApps.Start(Seconds(2.0));
+        anycastClientApps.Stop(Seconds(15.0));
+    }
+
+    // Traffic pinned to Link A from 10.1.1.1 gets its replies back through Branch too
+    if (transfer == "multipath" || failoverClients > 0)
+    {
+        staticRoutingN2->AddHostRouteTo(Ipv4Address("10.1.1.1"), Ipv4Address("10.1.3.1"), 2);
+    }
+
+    // --- Bulk Transfer: HQ (n0) -> DC (n2), single path or multipath ---
+
+    uint64_t transferBytes = uint64_t(transferMb) * 1000000;
+    uint16_t transferPort = 5000;
+    GoodputMonitor transferMonitor(Seconds(4.0));
+    Ptr<MultipathBulkSender> multipathSender;
+    if (transfer != "none")
+    {
+        PacketSinkHelper transferSink("ns3::TcpSocketFactory",
+                                      InetSocketAddress(Ipv4Address::GetAny(), transferPort));
+        ApplicationContainer transferSinkApps = transferSink.Install(n2);
+        transferSinkApps.Start(Seconds(1.0));
+        transferSinkApps.Stop(Seconds(15.0));
+        transferMonitor.Install(DynamicCast<PacketSink>(transferSinkApps.Get(0)));
+    }
+    if (transfer == "single")
+    {
+        // One connection on the primary route; static routing never moves it off Link B
+        BulkSendHelper bulk("ns3::TcpSocketFactory",
+                            InetSocketAddress(dc_address_on_branch_link, transferPort));
+        bulk.SetAttribute("MaxBytes", UintegerValue(transferBytes));
+        ApplicationContainer bulkApps = bulk.Install(n0);
+        bulkApps.Start(Seconds(2.0));
+        bulkApps.Stop(Seconds(15.0));
+    }
+    else if (transfer == "multipath")
+    {
+        // Subflow 1 over Link B; subflow 2 leaves on Link A towards DC's Link C address
+        multipathSender = CreateObject<MultipathBulkSender>();
+        multipathSender->SetAttribute("MaxBytes", UintegerValue(transferBytes));
+        multipathSender->AddSubflow(n0_HQDC_Device,
+                                    InetSocketAddress(interfacesHQDC.GetAddress(1), transferPort));
+        multipathSender->AddSubflow(linkHQBranchDevices.Get(0),
+                                    InetSocketAddress(dc_address_on_branch_link, transferPort));
+        n0->AddApplication(multipathSender);
+        multipathSender->SetStartTime(Seconds(2.0));
+        multipathSender->SetStopTime(Seconds(15.0));
+    }
+
+    // --- Failover Clients: HQ (n0) -> DC on Link B, else DC via Branch ---
+
+    Ptr<TimerWheel> failoverTimers = Create<TimerWheel>(MilliSeconds(10), 1024);
+    std::vector<Ptr<FailoverEchoClient>> failoverApps;
+    for (uint32_t i = 0; i < failoverClients; ++i)
+    {
+        Ptr<FailoverEchoClient> client = CreateObject<FailoverEchoClient>();
+        client->SetAttribute("Interval", TimeValue(MilliSeconds(200)));
+        client->SetAttribute("PacketSize", UintegerValue(packetSize));
+        client->SetTimerWheel(failoverTimers);
+        client->AddServer(InetSocketAddress(interfacesHQDC.GetAddress(1), port),
+                          n0_HQDC_Device);
+        client->AddServer(InetSocketAddress(dc_address_on_branch_link, port),
+                          linkHQBranchDevices.Get(0));
+        n0->AddApplication(client);
+        // Spread the clients over one interval
+        client->SetStartTime(Seconds(2.0) + MilliSeconds(200) * i / failoverClients);
+        client->SetStopTime(Seconds(15.0));
+        failoverApps.push_back(client);
+    }
 
     // --- Visualization and Tracing ---
     
@@ -214,25 +1114,200 @@ main(int argc, char* argv[])
     n1->GetObject<MobilityModel>()->SetPosition(Vector(10.0, 0.0, 0.0));  // Branch (Bottom)
     n2->GetObject<MobilityModel>()->SetPosition(Vector(20.0, 10.0, 0.0)); // DC (Right)
 
-    AnimationInterface anim("scratch/exercise1-redundant-wan.xml");
+    AnimationInterface anim(outputPrefix + ".xml");
     anim.UpdateNodeDescription(n0, "HQ (n0)");
     anim.UpdateNodeDescription(n1, "Branch (n1)");
     anim.UpdateNodeDescription(n2, "DC (n2)");
+    if (anycast)
+    {
+        mobility.Install(dcWest);
+        dcWest.Get(0)->GetObject<MobilityModel>()->SetPosition(Vector(20.0, 0.0, 0.0));
+        anim.UpdateNodeDescription(dcWest.Get(0), "DC-West (n3)");
+    }
     
     // Print routing tables at various times
     Ptr<OutputStreamWrapper> routingStream =
-        Create<OutputStreamWrapper>("scratch/exercise1-redundant-wan.routes", std::ios::out);
+        Create<OutputStreamWrapper>(outputPrefix + ".routes", std::ios::out);
     // Before failure
     staticRoutingHelper.PrintRoutingTableAllAt(Seconds(1.0), routingStream); 
     // After failure
     staticRoutingHelper.PrintRoutingTableAllAt(Seconds(5.0), routingStream); 
 
     // Enable PCAP tracing
-    p2p.EnablePcapAll("scratch/exercise1-redundant-wan");
+    p2p.EnablePcapAll(outputPrefix);
+
+    // Fragmentation counters on every router
+    FragmentationStats fragmentationStats;
+    fragmentationStats.Install(nodes);
+
+    // Sampled flow export on every router
+    Ptr<FlowExporter> flowExporter;
+    if (flowSampling > 0)
+    {
+        flowExporter = Create<FlowExporter>(outputPrefix + ".flows",
+                                            flowSampling,
+                                            flowCache);
+        // Short timeouts so that the 16 s run exports records before the end
+        flowExporter->SetInactiveTimeout(Seconds(2.0));
+        flowExporter->SetActiveTimeout(Seconds(5.0));
+        flowExporter->Install(nodes);
+    }
+
+    // WAN optimizers on both directions of Link C (the slow backup leg)
+    WanOptimizer optimizerBranchToDC(uint64_t(dedupCacheKb) * 1024, dedupChunk);
+    WanOptimizer optimizerDCToBranch(uint64_t(dedupCacheKb) * 1024, dedupChunk);
+    if (dedup)
+    {
+        optimizerBranchToDC.Install(linkBranchDCDevices.Get(0));
+        optimizerDCToBranch.Install(linkBranchDCDevices.Get(1));
+    }
 
     // Run simulation
     Simulator::Stop(Seconds(16.0));
+    auto runStart = std::chrono::steady_clock::now();
     Simulator::Run();
+    double runSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+
+    std::cout << "\n=== IPv4 Fragmentation ===\n";
+    fragmentationStats.Print(std::cout);
+
+    if (flowExporter)
+    {
+        flowExporter->Flush();
+        std::cout << "\n=== Flow Export (1/" << flowSampling << ") ===\n";
+        flowExporter->Print(std::cout);
+    }
+
+    if (multicast)
+    {
+        std::cout << "\n=== Multicast " << multicastGroup << " ===\n";
+        std::cout << "HQ (n0) received: "
+                  << DynamicCast<PacketSink>(multicastSinks.Get(0))->GetTotalRx() << " bytes\n";
+        std::cout << "Branch (n1) received: "
+                  << DynamicCast<PacketSink>(multicastSinks.Get(1))->GetTotalRx() << " bytes\n";
+    }
+
+    if (anycast)
+    {
+        std::cout << "\n=== Anycast " << anycastAddress << " ===\n";
+        anycastService.Print(std::cout);
+    }
+
+    if (bgp)
+    {
+        std::cout << "\n=== BGP ===\n";
+        for (Ptr<BgpRouter> router : bgpRouters)
+        {
+            router->PrintSummary(std::cout);
+        }
+        std::cout << BgpAttributeStore::GetSize() << " distinct attribute sets, "
+                  << BgpAttributeStore::GetBytes() << " bytes\n";
+    }
+
+    if (transfer != "none")
+    {
+        std::cout << "\n=== Bulk Transfer (" << transfer << ") ===\n";
+        transferMonitor.Print(std::cout, Seconds(15.0), transferBytes);
+        if (multipathSender)
+        {
+            multipathSender->Print(std::cout);
+        }
+    }
+
+    if (packetTrains)
+    {
+        std::cout << "\n=== Packet Trains (window " << trainWindowUs << " us) ===\n";
+        const char* names[] = {"Link A", "Link B", "Link C"};
+        for (uint32_t i = 0; i < trainChannels.size(); ++i)
+        {
+            std::cout << names[i] << ": ";
+            trainChannels[i]->Print(std::cout);
+        }
+    }
+
+    if (!scheduler.empty())
+    {
+        std::cout << "\n=== Event Scheduler (" << scheduler << ") ===\n";
+        std::cout << Simulator::GetEventCount() << " events in " << runSeconds * 1000 << " ms ("
+                  << Simulator::GetEventCount() / runSeconds << " events/s)\n";
+        if (scheduler == "batch")
+        {
+            const SameTimeBatchScheduler::Stats& stats = SameTimeBatchScheduler::GetStats();
+            std::cout << stats.batches << " timestamps, " << double(stats.events) / stats.batches
+                      << " events per timestamp, largest batch " << stats.largest << "\n";
+        }
+    }
+
+    if (dialBackup)
+    {
+        std::cout << "\n=== Dial-on-Demand Backup ===\n";
+        dialOnDemand.Print(std::cout, Seconds(16.0));
+    }
+
+    if (hqShaper)
+    {
+        std::cout << "\n=== HQ Egress Shaper (Link B) ===\n";
+        hqShaper->Print(std::cout);
+    }
+
+    if (branchEngine)
+    {
+        std::cout << "\n=== Branch Forwarding (" << branchPps << " pps) ===\n";
+        branchEngine->Print(std::cout);
+    }
+
+    if (failoverClients > 0)
+    {
+        FailoverEchoClient::Stats total;
+        for (Ptr<FailoverEchoClient> client : failoverApps)
+        {
+            const FailoverEchoClient::Stats& stats = client->GetStats();
+            total.sent += stats.sent;
+            total.answered += stats.answered;
+            total.timeouts += stats.timeouts;
+            total.failovers += stats.failovers;
+            total.outage = std::max(total.outage, stats.outage);
+        }
+        std::cout << "\n=== Failover Clients (" << failoverClients << ") ===\n";
+        std::cout << "Requests sent " << total.sent << ", answered " << total.answered
+                  << ", timed out " << total.timeouts << ", failovers " << total.failovers
+                  << "\n";
+        std::cout << "Longest outage of a client: " << total.outage.As(Time::MS) << "\n";
+        std::cout << "Timer wheel: " << failoverTimers->GetNFired() << " timers in "
+                  << failoverTimers->GetNEvents() << " simulator events\n";
+        std::cout << "Client 0:\n";
+        failoverApps[0]->Print(std::cout);
+    }
+
+    if (sr)
+    {
+        std::cout << "\n=== Segment Routing ===\n";
+        srDomain->Print(std::cout);
+    }
+
+    if (tenants > 0)
+    {
+        std::cout << "\n=== Tenant VRFs ===\n";
+        std::cout << tenants << " tenants x " << vrfRouting.size() << " routers, "
+                  << VrfTable::GetInternedCount() << " distinct tables, "
+                  << VrfTable::GetInternedBytes() << " bytes of routes\n";
+        if (echoTenantNoRoute)
+        {
+            std::cout << "Tenant " << echoTenant << " without routes on HQ: " << tenantDrops
+                      << " echo requests dropped at HQ, " << echoRequestsServed
+                      << " delivered to DC\n";
+        }
+    }
+
+    if (dedup)
+    {
+        std::cout << "\n=== WAN Optimizer: Branch -> DC ===\n";
+        optimizerBranchToDC.Print(std::cout);
+        std::cout << "\n=== WAN Optimizer: DC -> Branch ===\n";
+        optimizerDCToBranch.Print(std::cout);
+    }
+
     Simulator::Destroy();
 
     std::cout << "\n=== Exercise 1 Simulation Complete ===\n";
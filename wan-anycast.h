@@ -0,0 +1,328 @@
+#ifndef WAN_ANYCAST_H
+#define WAN_ANYCAST_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/ipv4-static-routing.h"
+
+#include <algorithm>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief UDP echo server bound to an anycast address.
+ *
+ * UdpEchoServer binds to the wildcard address, so its replies leave with the
+ * address of the outgoing interface and a connected UdpEchoClient drops them.
+ * Binding to the anycast address makes the reply source match the request
+ * destination on every replica.
+ */
+class AnycastEchoServer : public Application
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::AnycastEchoServer")
+                .SetParent<Application>()
+                .AddConstructor<AnycastEchoServer>()
+                .AddAttribute("Local",
+                              "Anycast address and port to bind to.",
+                              AddressValue(),
+                              MakeAddressAccessor(&AnycastEchoServer::m_local),
+                              MakeAddressChecker())
+                .AddTraceSource("Rx",
+                                "A request has been received.",
+                                MakeTraceSourceAccessor(&AnycastEchoServer::m_rxTrace),
+                                "ns3::Packet::AddressTracedCallback");
+        return tid;
+    }
+
+  private:
+    void StartApplication() override
+    {
+        if (!m_socket)
+        {
+            m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+            NS_ABORT_MSG_IF(m_socket->Bind(m_local) == -1, "Failed to bind anycast socket");
+        }
+        m_socket->SetRecvCallback(MakeCallback(&AnycastEchoServer::HandleRead, this));
+    }
+
+    void StopApplication() override
+    {
+        if (m_socket)
+        {
+            m_socket->Close();
+            m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+        }
+    }
+
+    void HandleRead(Ptr<Socket> socket)
+    {
+        Ptr<Packet> packet;
+        Address from;
+        while ((packet = socket->RecvFrom(from)))
+        {
+            m_rxTrace(packet, from);
+            packet->RemoveAllPacketTags();
+            packet->RemoveAllByteTags();
+            socket->SendTo(packet, 0, from);
+        }
+    }
+
+    Address m_local;                                            //!< Anycast address and port
+    Ptr<Socket> m_socket;                                       //!< Bound UDP socket
+    TracedCallback<Ptr<const Packet>, const Address&> m_rxTrace; //!< Request and its sender
+};
+
+/**
+ * @brief Nearest-replica routing for one anycast address.
+ *
+ * Every replica owns the anycast address as a /32 on its loopback. Each
+ * router keeps a list of candidate paths sorted by metric and installs only
+ * the best one whose interface is still up as a host route, so a lookup
+ * stays a single static route whatever the number of replicas. LinkDown()
+ * withdraws the affected paths and installs the next best one.
+ */
+class AnycastService
+{
+  public:
+    /**
+     * @param address The anycast service address.
+     */
+    explicit AnycastService(Ipv4Address address)
+        : m_address(address)
+    {
+    }
+
+    /**
+     * @brief Give a node the anycast address and start an echo server on it.
+     *
+     * @param node Replica node.
+     * @param name Name used in the report.
+     * @param port UDP port of the echo service.
+     * @return The server application.
+     */
+    Ptr<AnycastEchoServer> AddReplica(Ptr<Node> node, const std::string& name, uint16_t port)
+    {
+        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+        ipv4->AddAddress(0, Ipv4InterfaceAddress(m_address, Ipv4Mask::GetOnes()));
+
+        Ptr<AnycastEchoServer> server = CreateObject<AnycastEchoServer>();
+        server->SetAttribute("Local", AddressValue(InetSocketAddress(m_address, port)));
+        node->AddApplication(server);
+
+        uint32_t index = m_replicas.size();
+        m_replicas.push_back(Replica{name, node->GetId(), 0});
+        server->TraceConnectWithoutContext(
+            "Rx",
+            MakeBoundCallback(&AnycastService::ServerRx, this, index));
+        return server;
+    }
+
+    /**
+     * @brief Register a path from a router towards a replica.
+     *
+     * @param router Node whose static routing gets the host route.
+     * @param nextHop Next hop towards the replica.
+     * @param interface Output interface towards the next hop.
+     * @param metric Distance to the replica; the lowest live one is used.
+     * @param replica Index returned by the order of AddReplica() calls.
+     */
+    void AddPath(Ptr<Node> router,
+                 Ipv4Address nextHop,
+                 uint32_t interface,
+                 uint32_t metric,
+                 uint32_t replica)
+    {
+        RouterState& state = m_routers[router->GetId()];
+        if (!state.routing)
+        {
+            Ipv4StaticRoutingHelper helper;
+            state.routing = helper.GetStaticRouting(router->GetObject<Ipv4>());
+        }
+        Path path{nextHop, interface, metric, replica, true};
+        auto pos = std::upper_bound(state.paths.begin(),
+                                    state.paths.end(),
+                                    path,
+                                    [](const Path& a, const Path& b) {
+                                        return a.metric < b.metric;
+                                    });
+        state.paths.insert(pos, path);
+        Reinstall(state);
+    }
+
+    /**
+     * @brief Withdraw every path leaving through a failed device.
+     *
+     * Schedule it next to DisableLink() for the same device. The switch-over
+     * time reported for the router ends when a request from a client on that
+     * router reaches its new replica.
+     *
+     * @param device The device that went down.
+     */
+    void LinkDown(Ptr<NetDevice> device)
+    {
+        auto it = m_routers.find(device->GetNode()->GetId());
+        if (it == m_routers.end())
+        {
+            return;
+        }
+        RouterState& state = it->second;
+        int32_t interface = device->GetNode()->GetObject<Ipv4>()->GetInterfaceForDevice(device);
+        bool changed = false;
+        for (Path& path : state.paths)
+        {
+            if (path.up && int32_t(path.interface) == interface)
+            {
+                path.up = false;
+                changed = true;
+            }
+        }
+        if (changed)
+        {
+            int32_t previous = state.active;
+            Reinstall(state);
+            if (state.active >= 0 && state.active != previous)
+            {
+                m_pending.push_back(Switchover{uint32_t(state.active),
+                                               device->GetNode()->GetObject<Ipv4>(),
+                                               Simulator::Now()});
+            }
+        }
+    }
+
+    /**
+     * @brief Write per-replica load, the load imbalance and switch-over times.
+     *
+     * @param os Output stream.
+     */
+    void Print(std::ostream& os) const
+    {
+        uint64_t total = 0;
+        uint64_t busiest = 0;
+        for (const Replica& r : m_replicas)
+        {
+            total += r.requests;
+            busiest = std::max(busiest, r.requests);
+        }
+        for (const Replica& r : m_replicas)
+        {
+            os << r.name << ": " << r.requests << " requests\n";
+        }
+        double mean = m_replicas.empty() ? 0.0 : double(total) / m_replicas.size();
+        os << "Load imbalance (max/mean): " << (mean > 0 ? busiest / mean : 0.0) << "\n";
+        for (const Time& t : m_switchoverTimes)
+        {
+            os << "Switch-over time: " << t.As(Time::MS) << "\n";
+        }
+        if (!m_pending.empty())
+        {
+            os << m_pending.size() << " switch-over(s) never completed\n";
+        }
+    }
+
+  private:
+    /// Candidate path from a router towards one replica.
+    struct Path
+    {
+        Ipv4Address nextHop; //!< Next hop address
+        uint32_t interface;  //!< Output interface
+        uint32_t metric;     //!< Distance to the replica
+        uint32_t replica;    //!< Replica index
+        bool up;             //!< False once the interface failed
+    };
+
+    /// Anycast state of one router.
+    struct RouterState
+    {
+        Ptr<Ipv4StaticRouting> routing; //!< Routing the host route lives in
+        std::vector<Path> paths;        //!< Candidates sorted by metric
+        int32_t active{-1};             //!< Replica currently routed to
+    };
+
+    /// Served replica.
+    struct Replica
+    {
+        std::string name;  //!< Report name
+        uint32_t nodeId;   //!< Node hosting the replica
+        uint64_t requests; //!< Requests answered
+    };
+
+    /// Route change waiting for the router's own traffic to reach its new replica.
+    struct Switchover
+    {
+        uint32_t replica; //!< Replica traffic moved to
+        Ptr<Ipv4> router; //!< Router whose route changed; its clients complete it
+        Time start;       //!< Time of the route change
+    };
+
+    void Reinstall(RouterState& state)
+    {
+        for (uint32_t i = 0; i < state.routing->GetNRoutes(); ++i)
+        {
+            if (state.routing->GetRoute(i).GetDest() == m_address)
+            {
+                state.routing->RemoveRoute(i);
+                break;
+            }
+        }
+        state.active = -1;
+        for (const Path& path : state.paths)
+        {
+            if (path.up)
+            {
+                state.routing->AddHostRouteTo(m_address,
+                                              path.nextHop,
+                                              path.interface,
+                                              path.metric);
+                state.active = path.replica;
+                return;
+            }
+        }
+    }
+
+    static void ServerRx(AnycastService* self,
+                         uint32_t replica,
+                         Ptr<const Packet> packet,
+                         const Address& from)
+    {
+        self->m_replicas[replica].requests++;
+        // Other routers' clients may already use the new replica: wait for this router's
+        Ipv4Address source = InetSocketAddress::ConvertFrom(from).GetIpv4();
+        for (auto it = self->m_pending.begin(); it != self->m_pending.end();)
+        {
+            if (it->replica == replica && it->router->GetInterfaceForAddress(source) >= 0)
+            {
+                self->m_switchoverTimes.push_back(Simulator::Now() - it->start);
+                it = self->m_pending.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    Ipv4Address m_address;                     //!< Anycast address
+    std::vector<Replica> m_replicas;           //!< Replicas in AddReplica() order
+    std::map<uint32_t, RouterState> m_routers; //!< Router state by node id
+    std::vector<Switchover> m_pending;         //!< Unfinished switch-overs
+    std::vector<Time> m_switchoverTimes;       //!< Completed switch-over durations
+};
+
+} // namespace ns3
+
+#endif /* WAN_ANYCAST_H */
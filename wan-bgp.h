@@ -0,0 +1,1435 @@
+#ifndef WAN_BGP_H
+#define WAN_BGP_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <map>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Path attributes of a BGP route.
+ */
+struct BgpAttributes
+{
+    std::vector<uint32_t> asPath;      //!< AS_PATH, nearest AS first
+    uint32_t nextHop{0};               //!< NEXT_HOP
+    uint32_t localPref{100};           //!< LOCAL_PREF (iBGP only)
+    uint32_t med{0};                   //!< MULTI_EXIT_DISC
+    uint32_t originatorId{0};          //!< ORIGINATOR_ID set by a route reflector
+    std::vector<uint32_t> clusterList; //!< CLUSTER_LIST set by route reflectors
+
+    bool operator==(const BgpAttributes& o) const
+    {
+        return asPath == o.asPath && nextHop == o.nextHop && localPref == o.localPref &&
+               med == o.med && originatorId == o.originatorId && clusterList == o.clusterList;
+    }
+};
+
+/**
+ * @brief Process-wide store of interned, reference-counted path attributes.
+ *
+ * RIB entries hold a 32-bit id instead of the attributes, so the thousands
+ * of prefixes sharing one AS path and next hop cost four bytes each. Every
+ * RIB entry and queued advertisement holding an id owns one reference; a
+ * set is freed with its last reference and its id reused, so route churn
+ * does not grow the store.
+ */
+class BgpAttributeStore
+{
+  public:
+    /// Id standing for "no attributes".
+    static constexpr uint32_t NONE = 0xffffffff;
+
+    /**
+     * @param attributes Attributes to intern.
+     * @return The id of the shared copy, with one reference owned by the caller.
+     */
+    static uint32_t Intern(const BgpAttributes& attributes)
+    {
+        Store& s = Get();
+        uint64_t h = Hash(attributes);
+        auto range = s.index.equal_range(h);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (s.entries[it->second].attributes == attributes)
+            {
+                s.entries[it->second].references++;
+                return it->second;
+            }
+        }
+        uint32_t id;
+        if (s.free.empty())
+        {
+            id = s.entries.size();
+            s.entries.emplace_back();
+        }
+        else
+        {
+            id = s.free.back();
+            s.free.pop_back();
+        }
+        s.entries[id] = Entry{attributes, h, 1};
+        s.index.emplace(h, id);
+        s.live++;
+        return id;
+    }
+
+    /// @param id Attribute id gaining a reference (NONE is ignored).
+    static void Ref(uint32_t id)
+    {
+        if (id != NONE)
+        {
+            Get().entries[id].references++;
+        }
+    }
+
+    /// @param id Attribute id losing a reference, freed with the last one (NONE is ignored).
+    static void Unref(uint32_t id)
+    {
+        if (id == NONE)
+        {
+            return;
+        }
+        Store& s = Get();
+        Entry& e = s.entries[id];
+        NS_ASSERT(e.references > 0);
+        if (--e.references > 0)
+        {
+            return;
+        }
+        auto range = s.index.equal_range(e.hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == id)
+            {
+                s.index.erase(it);
+                break;
+            }
+        }
+        e.attributes = BgpAttributes();
+        s.free.push_back(id);
+        s.live--;
+    }
+
+    /**
+     * @param id Attribute id.
+     * @return The attributes.
+     */
+    static const BgpAttributes& Lookup(uint32_t id)
+    {
+        return Get().entries[id].attributes;
+    }
+
+    /// @return Number of distinct attribute sets in use.
+    static size_t GetSize()
+    {
+        return Get().live;
+    }
+
+    /// @return Approximate heap bytes of the store.
+    static size_t GetBytes()
+    {
+        const Store& s = Get();
+        size_t bytes = s.entries.capacity() * sizeof(Entry) + s.free.capacity() * sizeof(uint32_t);
+        for (const Entry& e : s.entries)
+        {
+            bytes += (e.attributes.asPath.capacity() + e.attributes.clusterList.capacity()) *
+                     sizeof(uint32_t);
+        }
+        // Node, hash and bucket per index entry
+        return bytes + s.index.size() * 40;
+    }
+
+  private:
+    /// Attribute set and its reference count.
+    struct Entry
+    {
+        BgpAttributes attributes; //!< Attributes
+        uint64_t hash{0};         //!< Hash of the attributes
+        uint32_t references{0};   //!< Holders; 0 for a free id
+    };
+
+    /// Storage.
+    struct Store
+    {
+        std::vector<Entry> entries;                        //!< Sets by id
+        std::vector<uint32_t> free;                        //!< Ids of freed sets
+        std::unordered_multimap<uint64_t, uint32_t> index; //!< Hash -> id
+        size_t live{0};                                    //!< Sets in use
+    };
+
+    static Store& Get()
+    {
+        static Store store;
+        return store;
+    }
+
+    static uint64_t Hash(const BgpAttributes& a)
+    {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        auto mix = [&h](uint64_t v) { h = (h ^ v) * 0x100000001B3ULL; };
+        for (uint32_t as : a.asPath)
+        {
+            mix(as);
+        }
+        mix(a.nextHop);
+        mix(a.localPref);
+        mix(a.med);
+        mix(a.originatorId);
+        for (uint32_t c : a.clusterList)
+        {
+            mix(c);
+        }
+        return h;
+    }
+};
+
+/**
+ * @brief BGP message: KEEPALIVE, or UPDATE with withdrawals and one attribute set.
+ *
+ * Prefixes are encoded as 32-bit address plus 8-bit length.
+ */
+class BgpMessageHeader : public Header
+{
+  public:
+    /// Message types.
+    enum Type : uint8_t
+    {
+        UPDATE = 2,
+        KEEPALIVE = 4,
+    };
+
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::BgpMessageHeader")
+                                .SetParent<Header>()
+                                .AddConstructor<BgpMessageHeader>();
+        return tid;
+    }
+
+    TypeId GetInstanceTypeId() const override
+    {
+        return GetTypeId();
+    }
+
+    uint32_t GetSerializedSize() const override
+    {
+        uint32_t size = 1;
+        if (type == UPDATE)
+        {
+            size += 2 + 5 * withdrawn.size();
+            size += 1 + 4 * attributes.asPath.size() + 16 + 1 + 4 * attributes.clusterList.size();
+            size += 2 + 5 * nlri.size();
+        }
+        return size;
+    }
+
+    void Serialize(Buffer::Iterator i) const override
+    {
+        i.WriteU8(type);
+        if (type != UPDATE)
+        {
+            return;
+        }
+        WritePrefixes(i, withdrawn);
+        i.WriteU8(attributes.asPath.size());
+        for (uint32_t as : attributes.asPath)
+        {
+            i.WriteHtonU32(as);
+        }
+        i.WriteHtonU32(attributes.nextHop);
+        i.WriteHtonU32(attributes.localPref);
+        i.WriteHtonU32(attributes.med);
+        i.WriteHtonU32(attributes.originatorId);
+        i.WriteU8(attributes.clusterList.size());
+        for (uint32_t c : attributes.clusterList)
+        {
+            i.WriteHtonU32(c);
+        }
+        WritePrefixes(i, nlri);
+    }
+
+    uint32_t Deserialize(Buffer::Iterator start) override
+    {
+        Buffer::Iterator i = start;
+        type = Type(i.ReadU8());
+        if (type == UPDATE)
+        {
+            ReadPrefixes(i, withdrawn);
+            attributes.asPath.resize(i.ReadU8());
+            for (uint32_t& as : attributes.asPath)
+            {
+                as = i.ReadNtohU32();
+            }
+            attributes.nextHop = i.ReadNtohU32();
+            attributes.localPref = i.ReadNtohU32();
+            attributes.med = i.ReadNtohU32();
+            attributes.originatorId = i.ReadNtohU32();
+            attributes.clusterList.resize(i.ReadU8());
+            for (uint32_t& c : attributes.clusterList)
+            {
+                c = i.ReadNtohU32();
+            }
+            ReadPrefixes(i, nlri);
+        }
+        return i.GetDistanceFrom(start);
+    }
+
+    void Print(std::ostream& os) const override
+    {
+        os << (type == UPDATE ? "UPDATE" : "KEEPALIVE");
+        if (type == UPDATE)
+        {
+            os << " withdrawn=" << withdrawn.size() << " nlri=" << nlri.size();
+        }
+    }
+
+    Type type{KEEPALIVE};          //!< Message type
+    std::vector<uint64_t> withdrawn; //!< Withdrawn prefix keys
+    BgpAttributes attributes;      //!< Attributes of every NLRI prefix
+    std::vector<uint64_t> nlri;    //!< Announced prefix keys
+
+  private:
+    static void WritePrefixes(Buffer::Iterator& i, const std::vector<uint64_t>& prefixes)
+    {
+        i.WriteHtonU16(prefixes.size());
+        for (uint64_t key : prefixes)
+        {
+            i.WriteHtonU32(uint32_t(key >> 8));
+            i.WriteU8(uint8_t(key));
+        }
+    }
+
+    static void ReadPrefixes(Buffer::Iterator& i, std::vector<uint64_t>& prefixes)
+    {
+        prefixes.resize(i.ReadNtohU16());
+        for (uint64_t& key : prefixes)
+        {
+            uint64_t address = i.ReadNtohU32();
+            key = address << 8 | i.ReadU8();
+        }
+    }
+};
+
+/**
+ * @brief BGP speaker and its Loc-RIB as an IPv4 routing protocol.
+ *
+ * Sessions are single-hop UDP exchanges over the point-to-point links, kept
+ * alive by KEEPALIVEs and torn down by the hold timer. Received UPDATEs only
+ * mark prefixes dirty; the decision process runs once per batch window over
+ * all dirty prefixes, and outgoing changes are grouped by attribute set and
+ * sent once per MRAI interval per peer. Best paths resolve to the session
+ * neighbour they were learned from.
+ *
+ * The RIBs are flat arrays indexed by one sorted prefix table per router:
+ * 8 bytes of prefix, 6 bytes of Loc-RIB (attribute id and peer) and 4
+ * bytes of Adj-RIB-In per session that holds routes, with no per-entry
+ * allocation. New prefixes of an UPDATE are merged into the table in one
+ * pass and prefixes left without routes are compacted away after a
+ * decision run. No Adj-RIB-Out is kept: what a peer holds is the export of
+ * the previous Loc-RIB best path, so a change is queued only when the
+ * export of the new best differs from it.
+ *
+ * Best-path order: local origination, highest LOCAL_PREF, shortest AS_PATH,
+ * lowest MED, eBGP over iBGP, shortest CLUSTER_LIST, lowest peer address.
+ *
+ * With IdleFastForward an established session that is being heard costs
+ * nothing while idle: no KEEPALIVEs are sent and the keepalive timer stops
+ * once every session is in that state. The session is treated as alive
+ * until a link event says otherwise (see NotifyPeerSilent()); its hold
+ * timer then runs from that moment and the timer restarts until all
+ * sessions are idle again. A session that is down is retried at doubling
+ * gaps, MAX_RETRIES times, and then waits for its interface to come up or
+ * the peer to be heard. A long run thus costs events per failure and
+ * recovery rather than per keepalive interval.
+ */
+class BgpRouter : public Ipv4RoutingProtocol
+{
+  public:
+    /// UDP port of the sessions.
+    static constexpr uint16_t PORT = 179;
+    /// KEEPALIVEs to a down session under IdleFastForward before it waits for a link event.
+    static constexpr uint32_t MAX_RETRIES = 6;
+    /// Peer index meaning "originated locally".
+    static constexpr uint16_t LOCAL = 0xffff;
+
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::BgpRouter")
+                .SetParent<Ipv4RoutingProtocol>()
+                .AddConstructor<BgpRouter>()
+                .AddAttribute("KeepaliveInterval",
+                              "Time between KEEPALIVE messages.",
+                              TimeValue(Seconds(1)),
+                              MakeTimeAccessor(&BgpRouter::m_keepalive),
+                              MakeTimeChecker())
+                .AddAttribute("HoldTime",
+                              "Silence after which a session is declared down.",
+                              TimeValue(Seconds(3)),
+                              MakeTimeAccessor(&BgpRouter::m_holdTime),
+                              MakeTimeChecker())
+                .AddAttribute("Mrai",
+                              "Minimum interval between UPDATE batches to one peer.",
+                              TimeValue(MilliSeconds(100)),
+                              MakeTimeAccessor(&BgpRouter::m_mrai),
+                              MakeTimeChecker())
+                .AddAttribute("BatchDelay",
+                              "Window collecting received changes before one decision run.",
+                              TimeValue(MilliSeconds(1)),
+                              MakeTimeAccessor(&BgpRouter::m_batchDelay),
+                              MakeTimeChecker())
+                .AddAttribute("IdleFastForward",
+                              "Send no KEEPALIVEs on idle sessions; link events end them.",
+                              BooleanValue(false),
+                              MakeBooleanAccessor(&BgpRouter::m_fastForward),
+                              MakeBooleanChecker());
+        return tid;
+    }
+
+    /**
+     * @param asn Autonomous system number.
+     * @param routerId Router id, also used as cluster id when reflecting.
+     */
+    void SetIdentity(uint32_t asn, Ipv4Address routerId)
+    {
+        m_asn = asn;
+        m_routerId = routerId.Get();
+    }
+
+    /**
+     * @brief Configure a session over a directly connected link.
+     *
+     * @param interface Local interface of the link.
+     * @param peerAddress Neighbour address on the link.
+     * @param peerAsn Neighbour AS; equal to ours for iBGP.
+     * @param routeReflectorClient True if we reflect routes to this iBGP peer.
+     * @param importLocalPref LOCAL_PREF given to routes learned over eBGP.
+     */
+    void AddPeer(uint32_t interface,
+                 Ipv4Address peerAddress,
+                 uint32_t peerAsn,
+                 bool routeReflectorClient = false,
+                 uint32_t importLocalPref = 100)
+    {
+        Peer peer;
+        peer.interface = interface;
+        peer.address = peerAddress;
+        peer.asn = peerAsn;
+        peer.rrClient = routeReflectorClient;
+        peer.importLocalPref = importLocalPref;
+        m_peers.push_back(peer);
+    }
+
+    /**
+     * @brief Originate a prefix from this router.
+     *
+     * @param network Network address.
+     * @param mask Network mask.
+     */
+    void Originate(Ipv4Address network, Ipv4Mask mask)
+    {
+        uint64_t key = Key(network.CombineMask(mask), mask.GetPrefixLength());
+        auto pos = std::lower_bound(m_originated.begin(), m_originated.end(), key);
+        if (pos == m_originated.end() || *pos != key)
+        {
+            m_originated.insert(pos, key);
+        }
+        AddPrefixes({key});
+        m_dirty.push_back(key);
+        ScheduleDecision();
+    }
+
+    /**
+     * @brief Tell the router that a peer can no longer be heard.
+     *
+     * Idle sessions exchange no KEEPALIVEs under IdleFastForward, so a
+     * failure that does not take down an interface of this router has to be
+     * signalled: the hold timer of the session then runs as if the last
+     * KEEPALIVE had just arrived. Interface failures at either end of a
+     * session are signalled automatically, other link failures through
+     * SignalLinkSilent(). Does nothing without IdleFastForward.
+     *
+     * @param peerAddress Neighbour address of the session.
+     */
+    void NotifyPeerSilent(Ipv4Address peerAddress)
+    {
+        if (!m_fastForward)
+        {
+            return;
+        }
+        for (Peer& p : m_peers)
+        {
+            if (p.address == peerAddress && p.established && !p.silent)
+            {
+                p.silent = true;
+                p.lastHeard = Simulator::Now();
+            }
+        }
+        WakeKeepalives();
+    }
+
+    /**
+     * @brief Tell the BGP speakers at both ends of a link that it went silent.
+     *
+     * Call it for a failure that takes no interface down, such as a device
+     * set inactive: every speaker on the link's channel marks the sessions
+     * to the other ends silent (see NotifyPeerSilent()).
+     *
+     * @param device Any device of the failed link.
+     */
+    static void SignalLinkSilent(Ptr<NetDevice> device)
+    {
+        Ptr<Channel> channel = device->GetChannel();
+        for (std::size_t i = 0; channel && i < channel->GetNDevices(); ++i)
+        {
+            Ptr<NetDevice> end = channel->GetDevice(i);
+            Ptr<BgpRouter> bgp = GetBgpRouter(end->GetNode());
+            for (std::size_t j = 0; bgp && j < channel->GetNDevices(); ++j)
+            {
+                Ptr<NetDevice> other = channel->GetDevice(j);
+                Ptr<Ipv4> ipv4 = other->GetNode()->GetObject<Ipv4>();
+                int32_t interface = ipv4 ? ipv4->GetInterfaceForDevice(other) : -1;
+                if (other != end && interface >= 0 && ipv4->GetNAddresses(interface) > 0)
+                {
+                    bgp->NotifyPeerSilent(ipv4->GetAddress(interface, 0).GetLocal());
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Write session states, RIB sizes and footprint, and message counters.
+     *
+     * @param os Output stream.
+     */
+    void PrintSummary(std::ostream& os) const
+    {
+        size_t adjIn = 0;
+        for (const Peer& p : m_peers)
+        {
+            adjIn += p.adjRibIn.size() -
+                     std::count(p.adjRibIn.begin(), p.adjRibIn.end(), BgpAttributeStore::NONE);
+        }
+        os << "AS" << m_asn << " " << Ipv4Address(m_routerId) << ": Loc-RIB " << LocRibSize()
+           << ", Adj-RIB-In " << adjIn << ", RIB " << GetRibBytes() << " bytes, UPDATEs sent "
+           << m_updatesSent << ", KEEPALIVEs sent " << m_keepalivesSent << ", decision runs "
+           << m_decisionRuns << "\n";
+        for (const Peer& p : m_peers)
+        {
+            os << "  peer " << p.address << " AS" << p.asn
+               << (p.established ? " established" : " down") << "\n";
+        }
+    }
+
+    /// @return Bytes held by the prefix table, Loc-RIB, Adj-RIBs-In and queued changes.
+    size_t GetRibBytes() const
+    {
+        size_t bytes = m_prefixes.capacity() * sizeof(uint64_t) +
+                       m_bestAttributes.capacity() * sizeof(uint32_t) +
+                       m_bestPeer.capacity() * sizeof(uint16_t) +
+                       m_originated.capacity() * sizeof(uint64_t);
+        for (const Peer& p : m_peers)
+        {
+            bytes += p.adjRibIn.capacity() * sizeof(uint32_t) +
+                     p.pending.capacity() * sizeof(p.pending[0]);
+        }
+        return bytes;
+    }
+
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                               const Ipv4Header& header,
+                               Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override
+    {
+        Ptr<Ipv4Route> route = Lookup(header.GetDestination());
+        if (route && oif && route->GetOutputDevice() != oif)
+        {
+            route = nullptr;
+        }
+        sockerr = route ? Socket::ERROR_NOTERROR : Socket::ERROR_NOROUTETOHOST;
+        return route;
+    }
+
+    bool RouteInput(Ptr<const Packet> p,
+                    const Ipv4Header& header,
+                    Ptr<const NetDevice> idev,
+                    const UnicastForwardCallback& ucb,
+                    const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb,
+                    const ErrorCallback& ecb) override
+    {
+        if (header.GetDestination().IsMulticast())
+        {
+            return false;
+        }
+        Ptr<Ipv4Route> route = Lookup(header.GetDestination());
+        if (!route)
+        {
+            return false;
+        }
+        ucb(route, p, header);
+        return true;
+    }
+
+    void NotifyInterfaceUp(uint32_t interface) override
+    {
+        for (Peer& p : m_peers)
+        {
+            if (p.interface == interface && !p.established)
+            {
+                p.retries = 0;
+                p.retryAt = Simulator::Now();
+            }
+        }
+        if (m_fastForward)
+        {
+            WakeKeepalives();
+        }
+    }
+
+    void NotifyInterfaceDown(uint32_t interface) override
+    {
+        for (uint16_t i = 0; i < m_peers.size(); ++i)
+        {
+            if (m_peers[i].interface == interface && m_peers[i].established)
+            {
+                PeerDown(i);
+            }
+        }
+        if (m_fastForward)
+        {
+            SignalSilence(interface);
+            WakeKeepalives();
+        }
+    }
+
+    void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void SetIpv4(Ptr<Ipv4> ipv4) override
+    {
+        m_ipv4 = ipv4;
+    }
+
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+                           Time::Unit unit = Time::S) const override
+    {
+        std::ostream& os = *stream->GetStream();
+        os << "BGP Loc-RIB of AS" << m_asn << " " << Ipv4Address(m_routerId) << "\n";
+        for (uint32_t length = 33; length-- > 0;)
+        {
+            for (size_t i = 0; i < m_prefixes.size(); ++i)
+            {
+                if ((m_prefixes[i] & 0xff) != length || m_bestAttributes[i] == WITHDRAW)
+                {
+                    continue;
+                }
+                const BgpAttributes& a = BgpAttributeStore::Lookup(m_bestAttributes[i]);
+                os << "  " << Ipv4Address(uint32_t(m_prefixes[i] >> 8)) << "/" << length
+                   << " via "
+                   << (m_bestPeer[i] == LOCAL ? Ipv4Address::GetAny()
+                                              : m_peers[m_bestPeer[i]].address)
+                   << " lp " << a.localPref << " path";
+                for (uint32_t as : a.asPath)
+                {
+                    os << " " << as;
+                }
+                os << "\n";
+            }
+        }
+    }
+
+  protected:
+    void DoInitialize() override
+    {
+        m_socket = Socket::CreateSocket(m_ipv4->GetObject<Node>(), UdpSocketFactory::GetTypeId());
+        m_socket->Bind(InetSocketAddress(Ipv4Address::GetAny(), PORT));
+        m_socket->SetRecvCallback(MakeCallback(&BgpRouter::Receive, this));
+        m_keepaliveEvent = Simulator::ScheduleNow(&BgpRouter::KeepaliveTick, this);
+        Ipv4RoutingProtocol::DoInitialize();
+    }
+
+    void DoDispose() override
+    {
+        if (m_socket)
+        {
+            m_socket->Close();
+            m_socket = nullptr;
+        }
+        m_keepaliveEvent.Cancel();
+        m_decisionEvent.Cancel();
+        // Give the attribute references back to the process-wide store
+        for (uint32_t id : m_bestAttributes)
+        {
+            BgpAttributeStore::Unref(id);
+        }
+        for (Peer& p : m_peers)
+        {
+            p.flushEvent.Cancel();
+            for (uint32_t id : p.adjRibIn)
+            {
+                BgpAttributeStore::Unref(id);
+            }
+            for (const auto& change : p.pending)
+            {
+                BgpAttributeStore::Unref(change.second);
+            }
+            p.adjRibIn.clear();
+            p.pending.clear();
+        }
+        m_prefixes.clear();
+        m_bestAttributes.clear();
+        m_bestPeer.clear();
+        m_ipv4 = nullptr;
+        Ipv4RoutingProtocol::DoDispose();
+    }
+
+  private:
+    /// Attribute id meaning "no route", or "withdraw" in an outgoing queue.
+    static constexpr uint32_t WITHDRAW = BgpAttributeStore::NONE;
+    /// Result of Find() for an unknown prefix.
+    static constexpr size_t NOT_FOUND = ~size_t(0);
+
+    /// Session state.
+    struct Peer
+    {
+        uint32_t interface{0};                               //!< Local interface
+        Ipv4Address address;                                 //!< Neighbour address
+        uint32_t asn{0};                                     //!< Neighbour AS
+        bool rrClient{false};                                //!< Reflect routes to it
+        uint32_t importLocalPref{100};                       //!< LOCAL_PREF for eBGP routes
+        bool established{false};                             //!< Session up
+        bool silent{false};                                  //!< Hold timer runs while idle
+        Time lastHeard;                                      //!< Last message received
+        uint32_t retries{0};                                 //!< KEEPALIVEs sent while down
+        Time retryAt;                                        //!< Next KEEPALIVE while down
+        std::vector<uint32_t> adjRibIn;                      //!< Attributes by prefix index
+        std::vector<std::pair<uint64_t, uint32_t>> pending; //!< Changes waiting for MRAI
+        EventId flushEvent;                                  //!< Pending MRAI flush
+        Time lastFlush;                                      //!< Time of the last flush
+    };
+
+    static uint64_t Key(Ipv4Address network, uint32_t length)
+    {
+        return uint64_t(network.Get()) << 8 | length;
+    }
+
+    bool IsIbgp(const Peer& p) const
+    {
+        return p.asn == m_asn;
+    }
+
+    size_t LocRibSize() const
+    {
+        size_t n = 0;
+        for (uint32_t routes : m_lengthRoutes)
+        {
+            n += routes;
+        }
+        return n;
+    }
+
+    /// @return Index of @p key in the prefix table, or NOT_FOUND.
+    size_t Find(uint64_t key) const
+    {
+        auto it = std::lower_bound(m_prefixes.begin(), m_prefixes.end(), key);
+        return it != m_prefixes.end() && *it == key ? size_t(it - m_prefixes.begin()) : NOT_FOUND;
+    }
+
+    /// Give the prefixes of @p keys that are not in the table a slot, in one merge.
+    void AddPrefixes(std::vector<uint64_t> keys)
+    {
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        keys.erase(std::remove_if(keys.begin(),
+                                  keys.end(),
+                                  [this](uint64_t key) { return Find(key) != NOT_FOUND; }),
+                   keys.end());
+        if (keys.empty())
+        {
+            return;
+        }
+        size_t i = m_prefixes.size();
+        size_t j = keys.size();
+        size_t k = i + j;
+        Resize(k);
+        // Merge from the back so that every entry moves at most once
+        while (j > 0)
+        {
+            --k;
+            if (i > 0 && m_prefixes[i - 1] > keys[j - 1])
+            {
+                Move(--i, k);
+            }
+            else
+            {
+                m_prefixes[k] = keys[--j];
+                m_bestAttributes[k] = WITHDRAW;
+                m_bestPeer[k] = LOCAL;
+                for (Peer& p : m_peers)
+                {
+                    if (!p.adjRibIn.empty())
+                    {
+                        p.adjRibIn[k] = WITHDRAW;
+                    }
+                }
+            }
+        }
+    }
+
+    /// Drop the prefixes left without a route.
+    void Compact()
+    {
+        size_t k = 0;
+        for (size_t i = 0; i < m_prefixes.size(); ++i)
+        {
+            if (m_bestAttributes[i] != WITHDRAW)
+            {
+                Move(i, k++);
+            }
+        }
+        Resize(k);
+        m_prefixes.shrink_to_fit();
+        m_bestAttributes.shrink_to_fit();
+        m_bestPeer.shrink_to_fit();
+        for (Peer& p : m_peers)
+        {
+            p.adjRibIn.shrink_to_fit();
+        }
+    }
+
+    /// Resize every prefix-indexed array; new slots hold no route.
+    void Resize(size_t size)
+    {
+        m_prefixes.resize(size);
+        m_bestAttributes.resize(size, WITHDRAW);
+        m_bestPeer.resize(size, LOCAL);
+        for (Peer& p : m_peers)
+        {
+            if (!p.adjRibIn.empty())
+            {
+                p.adjRibIn.resize(size, WITHDRAW);
+            }
+        }
+    }
+
+    /// Move prefix slot @p from to @p to in every prefix-indexed array.
+    void Move(size_t from, size_t to)
+    {
+        m_prefixes[to] = m_prefixes[from];
+        m_bestAttributes[to] = m_bestAttributes[from];
+        m_bestPeer[to] = m_bestPeer[from];
+        for (Peer& p : m_peers)
+        {
+            if (!p.adjRibIn.empty())
+            {
+                p.adjRibIn[to] = p.adjRibIn[from];
+            }
+        }
+    }
+
+    /// Remove a peer's route to prefix slot @p i, marking the prefix dirty.
+    void Withdraw(Peer& p, size_t i)
+    {
+        if (i != NOT_FOUND && !p.adjRibIn.empty() && p.adjRibIn[i] != WITHDRAW)
+        {
+            BgpAttributeStore::Unref(p.adjRibIn[i]);
+            p.adjRibIn[i] = WITHDRAW;
+            m_dirty.push_back(m_prefixes[i]);
+        }
+    }
+
+    void KeepaliveTick()
+    {
+        if (!m_fastForward)
+        {
+            for (uint16_t i = 0; i < m_peers.size(); ++i)
+            {
+                Peer& p = m_peers[i];
+                if (p.established && Simulator::Now() - p.lastHeard > m_holdTime)
+                {
+                    PeerDown(i);
+                }
+                SendKeepalive(p);
+            }
+            m_keepaliveEvent = Simulator::Schedule(m_keepalive, &BgpRouter::KeepaliveTick, this);
+            return;
+        }
+        Time now = Simulator::Now();
+        Time next = Time::Max();
+        for (uint16_t i = 0; i < m_peers.size(); ++i)
+        {
+            Peer& p = m_peers[i];
+            if (p.established && !p.silent)
+            {
+                continue;
+            }
+            if (p.established)
+            {
+                // Silent: keep the peer hearing us until the hold timer decides
+                if (now - p.lastHeard > m_holdTime)
+                {
+                    PeerDown(i);
+                }
+                else
+                {
+                    SendKeepalive(p);
+                    next = std::min(next, now + m_keepalive);
+                    continue;
+                }
+            }
+            // Down: retry at doubling gaps, then leave it to a link event
+            if (p.retries > MAX_RETRIES)
+            {
+                continue;
+            }
+            if (p.retryAt <= now)
+            {
+                SendKeepalive(p);
+                p.retryAt = now + m_keepalive * int64_t(1 << p.retries);
+                p.retries++;
+            }
+            if (p.retries <= MAX_RETRIES)
+            {
+                next = std::min(next, p.retryAt);
+            }
+        }
+        if (next != Time::Max())
+        {
+            m_keepaliveEvent = Simulator::Schedule(next - now, &BgpRouter::KeepaliveTick, this);
+        }
+    }
+
+    /// Run the keepalive timer now; it may be stopped or waiting for a distant retry.
+    void WakeKeepalives()
+    {
+        if (m_socket)
+        {
+            m_keepaliveEvent.Cancel();
+            m_keepaliveEvent = Simulator::ScheduleNow(&BgpRouter::KeepaliveTick, this);
+        }
+    }
+
+    /// Tell the BGP speakers across a failed interface that we went silent.
+    void SignalSilence(uint32_t interface)
+    {
+        Ptr<NetDevice> device = m_ipv4->GetNetDevice(interface);
+        Ptr<Channel> channel = device->GetChannel();
+        Ipv4Address local = m_ipv4->GetAddress(interface, 0).GetLocal();
+        for (std::size_t i = 0; channel && i < channel->GetNDevices(); ++i)
+        {
+            Ptr<NetDevice> other = channel->GetDevice(i);
+            Ptr<BgpRouter> bgp = GetBgpRouter(other->GetNode());
+            if (other != device && bgp)
+            {
+                bgp->NotifyPeerSilent(local);
+            }
+        }
+    }
+
+    /// @return The BGP speaker of a node, or nullptr if it runs none.
+    static Ptr<BgpRouter> GetBgpRouter(Ptr<Node> node)
+    {
+        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+        Ptr<Ipv4ListRouting> list =
+            ipv4 ? DynamicCast<Ipv4ListRouting>(ipv4->GetRoutingProtocol()) : nullptr;
+        for (uint32_t j = 0; list && j < list->GetNRoutingProtocols(); ++j)
+        {
+            int16_t priority;
+            Ptr<BgpRouter> bgp = DynamicCast<BgpRouter>(list->GetRoutingProtocol(j, priority));
+            if (bgp)
+            {
+                return bgp;
+            }
+        }
+        return nullptr;
+    }
+
+    void SendKeepalive(const Peer& p)
+    {
+        BgpMessageHeader keepalive;
+        Send(p, keepalive);
+        m_keepalivesSent++;
+    }
+
+    void Send(const Peer& p, const BgpMessageHeader& message)
+    {
+        Ptr<Packet> packet = Create<Packet>();
+        packet->AddHeader(message);
+        m_socket->SendTo(packet, 0, InetSocketAddress(p.address, PORT));
+    }
+
+    void Receive(Ptr<Socket> socket)
+    {
+        Ptr<Packet> packet;
+        Address from;
+        while ((packet = socket->RecvFrom(from)))
+        {
+            Ipv4Address source = InetSocketAddress::ConvertFrom(from).GetIpv4();
+            auto it = std::find_if(m_peers.begin(), m_peers.end(), [source](const Peer& p) {
+                return p.address == source;
+            });
+            if (it == m_peers.end())
+            {
+                continue;
+            }
+            uint16_t index = it - m_peers.begin();
+            Peer& p = *it;
+            p.lastHeard = Simulator::Now();
+            if (p.silent)
+            {
+                // Heard again before the hold timer expired; the peer may have reset
+                p.silent = false;
+                SendKeepalive(p);
+            }
+            if (!p.established)
+            {
+                PeerUp(index);
+            }
+            BgpMessageHeader message;
+            packet->RemoveHeader(message);
+            if (message.type == BgpMessageHeader::UPDATE)
+            {
+                ProcessUpdate(index, message);
+            }
+        }
+    }
+
+    void PeerUp(uint16_t index)
+    {
+        Peer& p = m_peers[index];
+        p.established = true;
+        if (m_fastForward)
+        {
+            // The peer stops sending once established, so it must hear us now
+            SendKeepalive(p);
+        }
+        // Initial table transfer: export the whole Loc-RIB to the new peer
+        for (size_t i = 0; i < m_prefixes.size(); ++i)
+        {
+            Export(index, m_prefixes[i], WITHDRAW, LOCAL, m_bestAttributes[i], m_bestPeer[i]);
+        }
+        ScheduleFlush(index);
+    }
+
+    void PeerDown(uint16_t index)
+    {
+        Peer& p = m_peers[index];
+        p.established = false;
+        p.silent = false;
+        p.retries = 0;
+        p.retryAt = Simulator::Now() + m_keepalive;
+        for (size_t i = 0; i < p.adjRibIn.size(); ++i)
+        {
+            Withdraw(p, i);
+        }
+        p.adjRibIn.clear();
+        p.adjRibIn.shrink_to_fit();
+        for (const auto& change : p.pending)
+        {
+            BgpAttributeStore::Unref(change.second);
+        }
+        p.pending.clear();
+        p.flushEvent.Cancel();
+        ScheduleDecision();
+    }
+
+    void ProcessUpdate(uint16_t index, const BgpMessageHeader& message)
+    {
+        Peer& p = m_peers[index];
+        for (uint64_t key : message.withdrawn)
+        {
+            Withdraw(p, Find(key));
+        }
+        if (!message.nlri.empty())
+        {
+            const BgpAttributes& a = message.attributes;
+            bool loop = std::find(a.asPath.begin(), a.asPath.end(), m_asn) != a.asPath.end() &&
+                        !IsIbgp(p);
+            loop |= a.originatorId == m_routerId;
+            loop |= std::find(a.clusterList.begin(), a.clusterList.end(), m_routerId) !=
+                    a.clusterList.end();
+            if (loop)
+            {
+                for (uint64_t key : message.nlri)
+                {
+                    Withdraw(p, Find(key));
+                }
+                ScheduleDecision();
+                return;
+            }
+            AddPrefixes(message.nlri);
+            if (p.adjRibIn.empty())
+            {
+                p.adjRibIn.assign(m_prefixes.size(), WITHDRAW);
+            }
+            BgpAttributes imported = a;
+            if (!IsIbgp(p))
+            {
+                imported.localPref = p.importLocalPref;
+            }
+            uint32_t id = BgpAttributeStore::Intern(imported);
+            for (uint64_t key : message.nlri)
+            {
+                size_t i = Find(key);
+                BgpAttributeStore::Ref(id);
+                BgpAttributeStore::Unref(p.adjRibIn[i]);
+                p.adjRibIn[i] = id;
+                m_dirty.push_back(key);
+            }
+            BgpAttributeStore::Unref(id);
+        }
+        ScheduleDecision();
+    }
+
+    void ScheduleDecision()
+    {
+        if (!m_decisionEvent.IsPending())
+        {
+            m_decisionEvent = Simulator::Schedule(m_batchDelay, &BgpRouter::Decide, this);
+        }
+    }
+
+    /// True if path a is preferred over path b.
+    bool Better(uint32_t aId, uint16_t aPeer, uint32_t bId, uint16_t bPeer) const
+    {
+        const BgpAttributes& a = BgpAttributeStore::Lookup(aId);
+        const BgpAttributes& b = BgpAttributeStore::Lookup(bId);
+        if (a.localPref != b.localPref)
+        {
+            return a.localPref > b.localPref;
+        }
+        if (a.asPath.size() != b.asPath.size())
+        {
+            return a.asPath.size() < b.asPath.size();
+        }
+        if (a.med != b.med)
+        {
+            return a.med < b.med;
+        }
+        bool aEbgp = !IsIbgp(m_peers[aPeer]);
+        bool bEbgp = !IsIbgp(m_peers[bPeer]);
+        if (aEbgp != bEbgp)
+        {
+            return aEbgp;
+        }
+        if (a.clusterList.size() != b.clusterList.size())
+        {
+            return a.clusterList.size() < b.clusterList.size();
+        }
+        return m_peers[aPeer].address < m_peers[bPeer].address;
+    }
+
+    void Decide()
+    {
+        m_decisionRuns++;
+        std::sort(m_dirty.begin(), m_dirty.end());
+        m_dirty.erase(std::unique(m_dirty.begin(), m_dirty.end()), m_dirty.end());
+        for (uint64_t key : m_dirty)
+        {
+            size_t i = Find(key);
+            if (i == NOT_FOUND)
+            {
+                continue;
+            }
+            uint32_t best = WITHDRAW;
+            uint16_t bestPeer = LOCAL;
+            bool originated = std::binary_search(m_originated.begin(), m_originated.end(), key);
+            if (originated)
+            {
+                BgpAttributes local;
+                local.nextHop = m_routerId;
+                best = BgpAttributeStore::Intern(local);
+            }
+            else
+            {
+                for (uint16_t n = 0; n < m_peers.size(); ++n)
+                {
+                    const std::vector<uint32_t>& in = m_peers[n].adjRibIn;
+                    if (!in.empty() && in[i] != WITHDRAW &&
+                        (best == WITHDRAW || Better(in[i], n, best, bestPeer)))
+                    {
+                        best = in[i];
+                        bestPeer = n;
+                    }
+                }
+            }
+            uint32_t previous = m_bestAttributes[i];
+            uint16_t previousPeer = m_bestPeer[i];
+            if (best != previous || (best != WITHDRAW && bestPeer != previousPeer))
+            {
+                uint32_t length = key & 0xff;
+                m_lengthRoutes[length] += (best != WITHDRAW) - (previous != WITHDRAW);
+                for (uint16_t n = 0; n < m_peers.size(); ++n)
+                {
+                    if (m_peers[n].established)
+                    {
+                        Export(n, key, previous, previousPeer, best, bestPeer);
+                        ScheduleFlush(n);
+                    }
+                }
+                BgpAttributeStore::Ref(best);
+                BgpAttributeStore::Unref(previous);
+                m_bestAttributes[i] = best;
+                m_bestPeer[i] = bestPeer;
+            }
+            if (originated)
+            {
+                BgpAttributeStore::Unref(best);
+            }
+        }
+        m_dirty.clear();
+        m_usedLengths = 0;
+        for (uint32_t length = 0; length <= 32; ++length)
+        {
+            m_usedLengths |= uint64_t(m_lengthRoutes[length] > 0) << length;
+        }
+        if (m_prefixes.size() > 2 * LocRibSize() + 1024)
+        {
+            Compact();
+        }
+    }
+
+    /**
+     * @brief Attributes of a Loc-RIB path as advertised to a peer.
+     *
+     * @param index Peer index.
+     * @param attributes Attribute id of the path, or WITHDRAW.
+     * @param from Peer the path was learned from, or LOCAL.
+     * @param out Receives the advertised attributes.
+     * @return False if the path is not advertised to the peer.
+     */
+    bool ExportAttributes(uint16_t index, uint32_t attributes, uint16_t from, BgpAttributes& out)
+    {
+        if (attributes == WITHDRAW || from == index)
+        {
+            return false;
+        }
+        const Peer& p = m_peers[index];
+        bool fromIbgp = from != LOCAL && IsIbgp(m_peers[from]);
+        bool fromClient = fromIbgp && m_peers[from].rrClient;
+        bool toIbgp = IsIbgp(p);
+        // iBGP-learned routes go to iBGP peers only through reflection
+        if (fromIbgp && toIbgp && !fromClient && !p.rrClient)
+        {
+            return false;
+        }
+        out = BgpAttributeStore::Lookup(attributes);
+        uint32_t local = m_ipv4->GetAddress(p.interface, 0).GetLocal().Get();
+        if (!toIbgp)
+        {
+            out.asPath.insert(out.asPath.begin(), m_asn);
+            out.nextHop = local;
+            out.localPref = 0;
+            out.med = 0;
+            out.originatorId = 0;
+            out.clusterList.clear();
+        }
+        else if (from == LOCAL)
+        {
+            out.nextHop = local;
+        }
+        else if (fromIbgp)
+        {
+            if (out.originatorId == 0)
+            {
+                out.originatorId = m_peers[from].address.Get();
+            }
+            out.clusterList.insert(out.clusterList.begin(), m_routerId);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Queue the change of a prefix's best path for a peer.
+     *
+     * The peer holds the export of the previous best path, so nothing is
+     * queued when the new one exports the same way.
+     */
+    void Export(uint16_t index,
+                uint64_t key,
+                uint32_t previous,
+                uint16_t previousPeer,
+                uint32_t best,
+                uint16_t bestPeer)
+    {
+        BgpAttributes before;
+        BgpAttributes after;
+        bool had = ExportAttributes(index, previous, previousPeer, before);
+        bool has = ExportAttributes(index, best, bestPeer, after);
+        if (had == has && (!has || before == after))
+        {
+            return;
+        }
+        m_peers[index].pending.emplace_back(key, has ? BgpAttributeStore::Intern(after) : WITHDRAW);
+    }
+
+    void ScheduleFlush(uint16_t index)
+    {
+        Peer& p = m_peers[index];
+        if (!p.flushEvent.IsPending() && !p.pending.empty())
+        {
+            Time wait = p.lastFlush + m_mrai > Simulator::Now()
+                            ? p.lastFlush + m_mrai - Simulator::Now()
+                            : Time(0);
+            p.flushEvent = Simulator::Schedule(wait, &BgpRouter::Flush, this, index);
+        }
+    }
+
+    void Flush(uint16_t index)
+    {
+        static constexpr size_t MAX_PREFIXES = 1000;
+        Peer& p = m_peers[index];
+        p.lastFlush = Simulator::Now();
+        // Only the last change queued for a prefix is sent
+        std::stable_sort(p.pending.begin(),
+                         p.pending.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        std::vector<uint64_t> withdrawn;
+        std::map<uint32_t, std::vector<uint64_t>> announced;
+        for (size_t i = 0; i < p.pending.size(); ++i)
+        {
+            const auto& change = p.pending[i];
+            if (i + 1 < p.pending.size() && p.pending[i + 1].first == change.first)
+            {
+                BgpAttributeStore::Unref(change.second);
+            }
+            else if (change.second == WITHDRAW)
+            {
+                withdrawn.push_back(change.first);
+            }
+            else
+            {
+                announced[change.second].push_back(change.first);
+            }
+        }
+        p.pending.clear();
+        p.pending.shrink_to_fit();
+        for (size_t i = 0; i < withdrawn.size(); i += MAX_PREFIXES)
+        {
+            BgpMessageHeader update;
+            update.type = BgpMessageHeader::UPDATE;
+            size_t end = std::min(withdrawn.size(), i + MAX_PREFIXES);
+            update.withdrawn.assign(withdrawn.begin() + i, withdrawn.begin() + end);
+            Send(p, update);
+            m_updatesSent++;
+        }
+        for (const auto& group : announced)
+        {
+            const std::vector<uint64_t>& keys = group.second;
+            for (size_t i = 0; i < keys.size(); i += MAX_PREFIXES)
+            {
+                BgpMessageHeader update;
+                update.type = BgpMessageHeader::UPDATE;
+                update.attributes = BgpAttributeStore::Lookup(group.first);
+                size_t end = std::min(keys.size(), i + MAX_PREFIXES);
+                update.nlri.assign(keys.begin() + i, keys.begin() + end);
+                Send(p, update);
+                m_updatesSent++;
+            }
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                BgpAttributeStore::Unref(group.first);
+            }
+        }
+    }
+
+    Ptr<Ipv4Route> Lookup(Ipv4Address dest) const
+    {
+        uint32_t d = dest.Get();
+        uint64_t lengths = m_usedLengths;
+        while (lengths)
+        {
+            int length = 63 - __builtin_clzll(lengths);
+            lengths &= ~(uint64_t(1) << length);
+            uint32_t mask = length ? ~uint32_t(0) << (32 - length) : 0;
+            size_t i = Find(Key(Ipv4Address(d & mask), length));
+            if (i == NOT_FOUND || m_bestAttributes[i] == WITHDRAW)
+            {
+                continue;
+            }
+            // Locally originated prefixes are connected; static routing handles them
+            if (m_bestPeer[i] == LOCAL)
+            {
+                return nullptr;
+            }
+            const Peer& p = m_peers[m_bestPeer[i]];
+            Ptr<Ipv4Route> route = Create<Ipv4Route>();
+            route->SetDestination(dest);
+            route->SetGateway(p.address);
+            route->SetOutputDevice(m_ipv4->GetNetDevice(p.interface));
+            route->SetSource(m_ipv4->GetAddress(p.interface, 0).GetLocal());
+            return route;
+        }
+        return nullptr;
+    }
+
+    Ptr<Ipv4> m_ipv4;                                    //!< IPv4 of the router
+    Ptr<Socket> m_socket;                                //!< Session socket
+    uint32_t m_asn{0};                                   //!< Own AS
+    uint32_t m_routerId{0};                              //!< Router and cluster id
+    Time m_keepalive;                                    //!< KEEPALIVE interval
+    Time m_holdTime;                                     //!< Hold time
+    Time m_mrai;                                         //!< MRAI
+    Time m_batchDelay;                                   //!< Decision batch window
+    bool m_fastForward{false};                           //!< Idle sessions send no KEEPALIVEs
+    std::vector<Peer> m_peers;                           //!< Sessions
+    std::vector<uint64_t> m_originated;                  //!< Prefixes originated here, sorted
+    std::vector<uint64_t> m_prefixes;                    //!< Known prefixes (Key()), sorted
+    std::vector<uint32_t> m_bestAttributes;              //!< Loc-RIB attributes by prefix index
+    std::vector<uint16_t> m_bestPeer;                    //!< Loc-RIB peer by prefix index
+    uint32_t m_lengthRoutes[33]{};                       //!< Loc-RIB routes by prefix length
+    uint64_t m_usedLengths{0};                           //!< Bit n set if /n is in the Loc-RIB
+    std::vector<uint64_t> m_dirty;                       //!< Prefixes awaiting a decision
+    EventId m_decisionEvent;                             //!< Pending decision run
+    EventId m_keepaliveEvent;                            //!< Next KEEPALIVE tick
+    uint64_t m_updatesSent{0};                           //!< UPDATE messages sent
+    uint64_t m_keepalivesSent{0};                        //!< KEEPALIVE messages sent
+    uint64_t m_decisionRuns{0};                          //!< Batched decision runs
+};
+
+/**
+ * @brief Add a BgpRouter in front of the static routing of a node.
+ *
+ * @param node Node with an installed Internet stack.
+ * @param asn Autonomous system number.
+ * @param routerId Router id.
+ * @return The BGP speaker.
+ */
+inline Ptr<BgpRouter>
+InstallBgp(Ptr<Node> node, uint32_t asn, Ipv4Address routerId)
+{
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+    Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(ipv4->GetRoutingProtocol());
+    NS_ABORT_MSG_IF(!list, "BGP needs the default Ipv4ListRouting");
+    Ptr<BgpRouter> bgp = CreateObject<BgpRouter>();
+    bgp->SetIdentity(asn, routerId);
+    list->AddRoutingProtocol(bgp, 1);
+    return bgp;
+}
+
+} // namespace ns3
+
+#endif /* WAN_BGP_H */
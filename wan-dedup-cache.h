@@ -0,0 +1,251 @@
+#ifndef WAN_DEDUP_CACHE_H
+#define WAN_DEDUP_CACHE_H
+
+#include "ns3/core-module.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Byte-level deduplication cache used by the WAN optimizer model.
+ *
+ * Payloads are cut into content-defined chunks with a Gear rolling hash,
+ * each chunk is fingerprinted, and chunks already present in the bounded
+ * LRU store are replaced by a short reference. Both ends of a link are
+ * assumed to hold the same store, so only the encoder side is modelled.
+ */
+class DedupCache
+{
+  public:
+    /// Bytes used on the wire for a reference to a stored chunk.
+    static constexpr uint32_t REFERENCE_SIZE = 10;
+    /// Bytes of framing added in front of a literal chunk.
+    static constexpr uint32_t LITERAL_HEADER_SIZE = 3;
+
+    /// Result of encoding one payload.
+    struct EncodeResult
+    {
+        uint32_t chunks{0};      //!< Chunks the payload was cut into
+        uint32_t hits{0};        //!< Chunks found in the store
+        uint32_t encodedSize{0}; //!< Bytes that would cross the link
+    };
+
+    /**
+     * @param capacityBytes Bytes of chunk data the store may hold.
+     * @param averageChunk Expected chunk size, at least 64; rounded down to a power of two.
+     */
+    DedupCache(uint64_t capacityBytes, uint32_t averageChunk)
+        : m_capacity(capacityBytes),
+          m_minChunk(averageChunk / 4),
+          m_maxChunk(averageChunk * 4)
+    {
+        // Smaller averages leave no room between the minimum and maximum chunk
+        NS_ABORT_MSG_IF(averageChunk < 64, "Average dedup chunk must be at least 64 bytes");
+        uint32_t bits = 0;
+        while ((2u << bits) <= averageChunk)
+        {
+            ++bits;
+        }
+        m_mask = (uint64_t(1) << bits) - 1;
+    }
+
+    /**
+     * @brief Chunk a payload, look every chunk up and insert the misses.
+     *
+     * @param data Payload bytes.
+     * @param size Payload length.
+     * @return Chunk, hit and encoded-size counts for the payload.
+     */
+    EncodeResult Encode(const uint8_t* data, uint32_t size)
+    {
+        EncodeResult result;
+        uint32_t start = 0;
+        while (start < size)
+        {
+            uint32_t length = NextBoundary(data + start, size - start);
+            uint64_t fp = Fingerprint(data + start, length);
+            result.chunks++;
+            if (Lookup(fp, data + start, length))
+            {
+                result.hits++;
+                result.encodedSize += REFERENCE_SIZE;
+            }
+            else
+            {
+                Insert(fp, data + start, length);
+                result.encodedSize += LITERAL_HEADER_SIZE + length;
+            }
+            start += length;
+        }
+        return result;
+    }
+
+    /// @return Bytes of chunk data currently stored.
+    uint64_t GetStoredBytes() const
+    {
+        return m_stored;
+    }
+
+    /// @return Number of chunks currently stored.
+    size_t GetStoredChunks() const
+    {
+        return m_lru.size();
+    }
+
+    /**
+     * @brief 64-bit chunk fingerprint computed over eight independent lanes.
+     *
+     * Each 32-bit lane consumes every eighth 4-byte word, so the inner loop
+     * has no cross-lane dependency and its body is one xor, multiply, shift
+     * and xor per lane. GCC 12 at -O3 turns it into a single vpmulld on a
+     * ymm register with -mavx2, or two pmulld with -msse4.1; baseline SSE2
+     * has no 32-bit lane multiply. The lanes are folded into 64 bits at the
+     * end.
+     *
+     * @param data Chunk bytes.
+     * @param size Chunk length.
+     * @return The fingerprint.
+     */
+    static uint64_t Fingerprint(const uint8_t* data, uint32_t size)
+    {
+        constexpr uint32_t lanePrime = 0x9E3779B1u;
+        constexpr uint64_t prime = 0x9E3779B97F4A7C15ULL;
+        uint32_t lanes[8];
+        for (uint32_t l = 0; l < 8; ++l)
+        {
+            lanes[l] = lanePrime ^ l;
+        }
+        uint32_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            uint32_t words[8];
+            std::memcpy(words, data + i, sizeof(words));
+            for (int l = 0; l < 8; ++l)
+            {
+                lanes[l] = (lanes[l] ^ words[l]) * lanePrime;
+                lanes[l] ^= lanes[l] >> 15;
+            }
+        }
+        uint64_t h = size;
+        for (int l = 0; l < 8; ++l)
+        {
+            h = (h ^ lanes[l]) * prime;
+        }
+        for (; i < size; ++i)
+        {
+            h = (h ^ data[i]) * prime;
+        }
+        return h ^ (h >> 32);
+    }
+
+  private:
+    /// Entry of the LRU store.
+    struct Chunk
+    {
+        uint64_t fingerprint;      //!< Fingerprint of the bytes
+        std::vector<uint8_t> data; //!< Stored bytes, used to rule out collisions
+    };
+
+    using ChunkList = std::list<Chunk>;
+
+    /// Gear table: one pseudo-random 64-bit value per byte value.
+    static const std::array<uint64_t, 256>& GearTable()
+    {
+        static const std::array<uint64_t, 256> table = [] {
+            std::array<uint64_t, 256> t{};
+            uint64_t x = 0x2545F4914F6CDD1DULL;
+            for (auto& v : t)
+            {
+                // splitmix64
+                x += 0x9E3779B97F4A7C15ULL;
+                uint64_t z = x;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                v = z ^ (z >> 31);
+            }
+            return t;
+        }();
+        return table;
+    }
+
+    uint32_t NextBoundary(const uint8_t* data, uint32_t size) const
+    {
+        if (size <= m_minChunk)
+        {
+            return size;
+        }
+        const std::array<uint64_t, 256>& gear = GearTable();
+        uint32_t limit = size < m_maxChunk ? size : m_maxChunk;
+        uint64_t h = 0;
+        for (uint32_t i = m_minChunk; i < limit; ++i)
+        {
+            h = (h << 1) + gear[data[i]];
+            if ((h & m_mask) == 0)
+            {
+                return i + 1;
+            }
+        }
+        return limit;
+    }
+
+    bool Lookup(uint64_t fp, const uint8_t* data, uint32_t size)
+    {
+        auto it = m_index.find(fp);
+        if (it == m_index.end())
+        {
+            return false;
+        }
+        const Chunk& chunk = *it->second;
+        if (chunk.data.size() != size || std::memcmp(chunk.data.data(), data, size) != 0)
+        {
+            return false;
+        }
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return true;
+    }
+
+    void Insert(uint64_t fp, const uint8_t* data, uint32_t size)
+    {
+        if (size > m_capacity)
+        {
+            return;
+        }
+        auto existing = m_index.find(fp);
+        if (existing != m_index.end())
+        {
+            // Fingerprint collision: the newer chunk replaces the older one
+            m_stored -= existing->second->data.size();
+            m_lru.erase(existing->second);
+            m_index.erase(existing);
+        }
+        while (m_stored + size > m_capacity)
+        {
+            const Chunk& victim = m_lru.back();
+            m_stored -= victim.data.size();
+            m_index.erase(victim.fingerprint);
+            m_lru.pop_back();
+        }
+        m_lru.push_front(Chunk{fp, std::vector<uint8_t>(data, data + size)});
+        m_index[fp] = m_lru.begin();
+        m_stored += size;
+    }
+
+    uint64_t m_capacity;                                     //!< Store budget in bytes
+    uint64_t m_stored{0};                                    //!< Bytes currently stored
+    uint32_t m_minChunk;                                     //!< Smallest chunk cut
+    uint32_t m_maxChunk;                                     //!< Largest chunk cut
+    uint64_t m_mask;                                         //!< Boundary mask of the rolling hash
+    ChunkList m_lru;                                         //!< Chunks, most recent first
+    std::unordered_map<uint64_t, ChunkList::iterator> m_index; //!< Fingerprint index
+};
+
+} // namespace ns3
+
+#endif /* WAN_DEDUP_CACHE_H */
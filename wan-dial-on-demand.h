@@ -0,0 +1,223 @@
+#ifndef WAN_DIAL_ON_DEMAND_H
+#define WAN_DIAL_ON_DEMAND_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/ipv4-static-routing-helper.h"
+
+#include <cmath>
+#include <ostream>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Dial-on-demand backup links with usage billing.
+ *
+ * Backup links start dormant: their IPv4 interfaces are down on both ends,
+ * so nothing is ever queued on them and they cost no simulator events.
+ * Taking an interface down makes static routing delete every route through
+ * it, so AddLink() first records the gateway routes through the link on
+ * both ends. When the primary fails its interfaces are taken down as well
+ * (which removes the routes through it) and, after the activation delay,
+ * the backup interfaces come up and the recorded routes, plus any floating
+ * routes registered with AddRoute(), are installed. Usage runs from activation to the end of the
+ * observation window and is billed as a setup charge plus started minutes.
+ */
+class DialOnDemandBackup
+{
+  public:
+    /**
+     * @param activationDelay Time to bring a backup link up (dial, train, authenticate).
+     * @param setupCharge Charge per activation of a link.
+     * @param perMinute Charge per started minute of use of a link.
+     */
+    DialOnDemandBackup(Time activationDelay, double setupCharge, double perMinute)
+        : m_activationDelay(activationDelay),
+          m_setupCharge(setupCharge),
+          m_perMinute(perMinute)
+    {
+    }
+
+    /**
+     * @brief Add a backup link and make it dormant.
+     *
+     * The static gateway routes through the link are recorded before its
+     * interfaces go down and restored, metrics included, on activation.
+     * Connected routes come back with the interfaces.
+     *
+     * @param devices The two devices of the link.
+     */
+    void AddLink(NetDeviceContainer devices)
+    {
+        Link link;
+        link.devices = devices;
+        m_links.push_back(link);
+        Ipv4StaticRoutingHelper helper;
+        for (uint32_t i = 0; i < devices.GetN(); ++i)
+        {
+            Ptr<Node> node = devices.Get(i)->GetNode();
+            Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+            int32_t interface = ipv4->GetInterfaceForDevice(devices.Get(i));
+            Ptr<Ipv4StaticRouting> routing = helper.GetStaticRouting(ipv4);
+            for (uint32_t r = 0; interface >= 0 && r < routing->GetNRoutes(); ++r)
+            {
+                Ipv4RoutingTableEntry entry = routing->GetRoute(r);
+                if (entry.GetInterface() == uint32_t(interface) && entry.IsGateway())
+                {
+                    m_routes.push_back(Route{node,
+                                             entry.GetDestNetwork(),
+                                             entry.GetDestNetworkMask(),
+                                             entry.GetGateway(),
+                                             entry.GetInterface(),
+                                             routing->GetMetric(r)});
+                }
+            }
+        }
+        SetState(devices, false);
+    }
+
+    /**
+     * @brief Add a route installed when the backup links come up.
+     *
+     * Routes that existed when AddLink() was called are restored anyway;
+     * this is for routes that only make sense once the backup is up.
+     *
+     * @param node Router.
+     * @param network Destination network.
+     * @param mask Network mask.
+     * @param nextHop Next hop on a backup link.
+     * @param interface Output interface.
+     * @param metric Route metric.
+     */
+    void AddRoute(Ptr<Node> node,
+                  Ipv4Address network,
+                  Ipv4Mask mask,
+                  Ipv4Address nextHop,
+                  uint32_t interface,
+                  uint32_t metric = 0)
+    {
+        m_routes.push_back(Route{node, network, mask, nextHop, interface, metric});
+    }
+
+    /**
+     * @brief React to a primary link failure.
+     *
+     * Schedule it next to DisableLink() for the same link. Only the first
+     * call dials; later failures find the backup already up.
+     *
+     * @param primary The two devices of the failed link.
+     */
+    void PrimaryDown(NetDeviceContainer primary)
+    {
+        SetState(primary, false);
+        if (!m_dialing)
+        {
+            m_dialing = true;
+            m_failedAt = Simulator::Now();
+            Simulator::Schedule(m_activationDelay, &DialOnDemandBackup::Activate, this);
+        }
+    }
+
+    /**
+     * @brief Write activation times, usage and charges.
+     *
+     * @param os Output stream.
+     * @param end End of the billing window.
+     */
+    void Print(std::ostream& os, Time end) const
+    {
+        double total = 0;
+        for (const Link& link : m_links)
+        {
+            os << "  n" << link.devices.Get(0)->GetNode()->GetId() << "-n"
+               << link.devices.Get(1)->GetNode()->GetId() << ": ";
+            if (!link.active)
+            {
+                os << "dormant, no charge\n";
+                continue;
+            }
+            double seconds = (end - link.activatedAt).GetSeconds();
+            uint64_t minutes = uint64_t(std::ceil(seconds / 60));
+            double cost = m_setupCharge + minutes * m_perMinute;
+            total += cost;
+            os << "up at " << link.activatedAt.As(Time::S) << " ("
+               << (link.activatedAt - m_failedAt).As(Time::MS) << " after the failure), "
+               << seconds << " s used, " << minutes << " min billed, cost " << cost << "\n";
+        }
+        os << "Total backup cost: " << total << "\n";
+    }
+
+  private:
+    /// A backup link.
+    struct Link
+    {
+        NetDeviceContainer devices; //!< Both ends
+        bool active{false};         //!< True once dialled
+        Time activatedAt;           //!< Activation time
+    };
+
+    /// A static route installed on activation.
+    struct Route
+    {
+        Ptr<Node> node;      //!< Router
+        Ipv4Address network; //!< Destination network
+        Ipv4Mask mask;       //!< Network mask
+        Ipv4Address nextHop; //!< Next hop
+        uint32_t interface;  //!< Output interface
+        uint32_t metric;     //!< Route metric
+    };
+
+    static void SetState(NetDeviceContainer devices, bool up)
+    {
+        for (uint32_t i = 0; i < devices.GetN(); ++i)
+        {
+            Ptr<NetDevice> device = devices.Get(i);
+            Ptr<Ipv4> ipv4 = device->GetNode()->GetObject<Ipv4>();
+            int32_t interface = ipv4->GetInterfaceForDevice(device);
+            NS_ABORT_MSG_IF(interface < 0, "Dial-on-demand links need IPv4 interfaces");
+            if (up)
+            {
+                ipv4->SetUp(interface);
+            }
+            else
+            {
+                ipv4->SetDown(interface);
+            }
+        }
+    }
+
+    void Activate()
+    {
+        for (Link& link : m_links)
+        {
+            SetState(link.devices, true);
+            link.active = true;
+            link.activatedAt = Simulator::Now();
+        }
+        Ipv4StaticRoutingHelper helper;
+        for (const Route& route : m_routes)
+        {
+            helper.GetStaticRouting(route.node->GetObject<Ipv4>())
+                ->AddNetworkRouteTo(route.network,
+                                    route.mask,
+                                    route.nextHop,
+                                    route.interface,
+                                    route.metric);
+        }
+    }
+
+    Time m_activationDelay;      //!< Dial time
+    double m_setupCharge;        //!< Charge per activation
+    double m_perMinute;          //!< Charge per started minute
+    std::vector<Link> m_links;   //!< Backup links
+    std::vector<Route> m_routes; //!< Routes installed on activation
+    bool m_dialing{false};       //!< True after the first failure
+    Time m_failedAt;             //!< Time of the first failure
+};
+
+} // namespace ns3
+
+#endif /* WAN_DIAL_ON_DEMAND_H */
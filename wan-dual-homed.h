@@ -0,0 +1,459 @@
+#ifndef WAN_DUAL_HOMED_H
+#define WAN_DUAL_HOMED_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include "wan-anycast.h"
+
+#include <chrono>
+#include <ostream>
+#include <unordered_map>
+
+namespace ns3
+{
+
+/**
+ * @brief Address plan and DC state shared by every router of a dual-homed design.
+ *
+ * Branch i has one /30 uplink to each DC; uplink j = 2 * i + k (k = DC index)
+ * is base + 4 * j, with the DC at .1 and the branch at .2. Every route is
+ * computed from this arithmetic plan, so routers keep no per-destination
+ * state and the whole design costs O(1) routing memory per router.
+ */
+class DualHomedPlan : public SimpleRefCount<DualHomedPlan>
+{
+  public:
+    /**
+     * @param base First uplink network.
+     * @param branches Number of branches.
+     */
+    DualHomedPlan(Ipv4Address base, uint32_t branches)
+        : m_base(base.Get()),
+          m_branches(branches)
+    {
+    }
+
+    /// @return Number of branches.
+    uint32_t GetNBranches() const
+    {
+        return m_branches;
+    }
+
+    /**
+     * @param dc DC index (0 or 1).
+     * @return True while the DC is up.
+     */
+    bool IsDcUp(uint32_t dc) const
+    {
+        return m_dcUp[dc];
+    }
+
+    /**
+     * @param dc DC index (0 or 1).
+     * @param up New state.
+     */
+    void SetDcUp(uint32_t dc, bool up)
+    {
+        m_dcUp[dc] = up;
+    }
+
+    /**
+     * @param branch Branch index.
+     * @param dc DC index.
+     * @param branchSide True for the branch end of the uplink.
+     * @return The address of one end of an uplink.
+     */
+    Ipv4Address GetUplinkAddress(uint32_t branch, uint32_t dc, bool branchSide) const
+    {
+        return Ipv4Address(m_base + 4 * (2 * branch + dc) + (branchSide ? 2 : 1));
+    }
+
+    /**
+     * @brief Find the uplink an address belongs to.
+     *
+     * @param address Any address.
+     * @param[out] branch Branch index.
+     * @param[out] dc DC index.
+     * @return False if the address is not on an uplink.
+     */
+    bool Locate(Ipv4Address address, uint32_t& branch, uint32_t& dc) const
+    {
+        uint32_t offset = address.Get() - m_base;
+        uint32_t link = offset / 4;
+        if (address.Get() < m_base || link >= 2 * m_branches)
+        {
+            return false;
+        }
+        branch = link / 2;
+        dc = link % 2;
+        return true;
+    }
+
+  private:
+    uint32_t m_base;            //!< First uplink network
+    uint32_t m_branches;        //!< Number of branches
+    bool m_dcUp[2]{true, true}; //!< DC state
+};
+
+/**
+ * @brief Routing of a branch or DC in a dual-homed design.
+ *
+ * A branch sends everything to its preferred DC (even branches prefer DC 0,
+ * odd ones DC 1) and to the other one while the preferred DC is down. A DC
+ * reaches a branch address on its own uplink directly, and one on the other
+ * DC's uplink through the DC interconnect unless the other DC is down.
+ *
+ * Interfaces follow RunDualHomedScenario(): a branch has 1 = DC 0 and
+ * 2 = DC 1; a DC has i + 1 towards branch i and N + 1 to the other DC.
+ */
+class DualHomedRouting : public Ipv4RoutingProtocol
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::DualHomedRouting")
+                                .SetParent<Ipv4RoutingProtocol>()
+                                .AddConstructor<DualHomedRouting>();
+        return tid;
+    }
+
+    /**
+     * @param plan Shared plan.
+     * @param isDc True for a DC.
+     * @param index Branch or DC index.
+     */
+    void SetRole(Ptr<DualHomedPlan> plan, bool isDc, uint32_t index)
+    {
+        m_plan = plan;
+        m_isDc = isDc;
+        m_index = index;
+    }
+
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                               const Ipv4Header& header,
+                               Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override
+    {
+        Ptr<Ipv4Route> route = Lookup(header.GetDestination());
+        if (route && oif && route->GetOutputDevice() != oif)
+        {
+            route = nullptr;
+        }
+        sockerr = route ? Socket::ERROR_NOTERROR : Socket::ERROR_NOROUTETOHOST;
+        return route;
+    }
+
+    bool RouteInput(Ptr<const Packet> p,
+                    const Ipv4Header& header,
+                    Ptr<const NetDevice> idev,
+                    const UnicastForwardCallback& ucb,
+                    const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb,
+                    const ErrorCallback& ecb) override
+    {
+        if (header.GetDestination().IsMulticast())
+        {
+            return false;
+        }
+        Ptr<Ipv4Route> route = Lookup(header.GetDestination());
+        if (!route)
+        {
+            return false;
+        }
+        ucb(route, p, header);
+        return true;
+    }
+
+    void NotifyInterfaceUp(uint32_t interface) override
+    {
+    }
+
+    void NotifyInterfaceDown(uint32_t interface) override
+    {
+    }
+
+    void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void SetIpv4(Ptr<Ipv4> ipv4) override
+    {
+        m_ipv4 = ipv4;
+    }
+
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+                           Time::Unit unit = Time::S) const override
+    {
+        *stream->GetStream() << (m_isDc ? "DC " : "Branch ") << m_index
+                             << ": routes computed from the shared dual-homed plan\n";
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_ipv4 = nullptr;
+        m_plan = nullptr;
+        Ipv4RoutingProtocol::DoDispose();
+    }
+
+  private:
+    Ptr<Ipv4Route> MakeRoute(Ipv4Address dest, Ipv4Address gateway, uint32_t interface) const
+    {
+        if (!m_ipv4->IsUp(interface))
+        {
+            return nullptr;
+        }
+        Ptr<Ipv4Route> route = Create<Ipv4Route>();
+        route->SetDestination(dest);
+        route->SetGateway(gateway);
+        route->SetOutputDevice(m_ipv4->GetNetDevice(interface));
+        route->SetSource(m_ipv4->GetAddress(interface, 0).GetLocal());
+        return route;
+    }
+
+    Ptr<Ipv4Route> Lookup(Ipv4Address dest) const
+    {
+        if (!m_isDc)
+        {
+            uint32_t dc = m_index % 2;
+            if (!m_plan->IsDcUp(dc))
+            {
+                dc = 1 - dc;
+            }
+            return MakeRoute(dest, m_plan->GetUplinkAddress(m_index, dc, false), dc + 1);
+        }
+        uint32_t branch;
+        uint32_t dc;
+        if (!m_plan->Locate(dest, branch, dc))
+        {
+            return nullptr;
+        }
+        uint32_t other = 1 - m_index;
+        if (dc == other && m_plan->IsDcUp(other))
+        {
+            // Over the interconnect: the other DC's end of it
+            uint32_t dci = m_plan->GetNBranches() + 1;
+            Ipv4Address self = m_ipv4->GetAddress(dci, 0).GetLocal();
+            Ipv4Address peer(self.Get() ^ 3);
+            return MakeRoute(dest, peer, dci);
+        }
+        // Weak host model: the branch accepts any of its addresses on either uplink
+        return MakeRoute(dest, m_plan->GetUplinkAddress(branch, m_index, true), branch + 1);
+    }
+
+    Ptr<Ipv4> m_ipv4;          //!< IPv4 of the router
+    Ptr<DualHomedPlan> m_plan; //!< Shared plan
+    bool m_isDc{false};        //!< True for a DC
+    uint32_t m_index{0};       //!< Branch or DC index
+};
+
+/**
+ * @brief Take a whole DC down: its interfaces and its entry in the plan.
+ *
+ * @param plan Shared plan.
+ * @param dc DC index.
+ * @param node The DC node.
+ */
+inline void
+FailDataCenter(Ptr<DualHomedPlan> plan, uint32_t dc, Ptr<Node> node)
+{
+    plan->SetDcUp(dc, false);
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+    for (uint32_t i = 1; i < ipv4->GetNInterfaces(); ++i)
+    {
+        ipv4->SetDown(i);
+    }
+}
+
+/**
+ * @brief Count a packet; connected to a server's Rx trace.
+ *
+ * @param count Counter.
+ * @param packet The packet.
+ * @param from Its sender.
+ */
+inline void
+CountDualHomedPacket(uint64_t* count, Ptr<const Packet> packet, const Address& from)
+{
+    ++*count;
+}
+
+/**
+ * @brief Requests of the dual-homed scenario and their answers.
+ *
+ * The echo server sends the request packet itself back, so an answer has
+ * the uid of its request and is binned by the request's send time: a
+ * request sent just before the failure and answered after it still counts
+ * before it.
+ */
+struct DualHomedRoundTrips
+{
+    std::unordered_map<uint64_t, Time> sent; //!< Send time by request uid
+    uint64_t answered[2]{0, 0};              //!< Answers to requests sent before, after 4 s
+};
+
+/**
+ * @brief Record the send time of a request; connected to a client's Tx trace.
+ *
+ * @param trips Round trip state.
+ * @param packet The request.
+ */
+inline void
+RecordDualHomedRequest(DualHomedRoundTrips* trips, Ptr<const Packet> packet)
+{
+    trips->sent[packet->GetUid()] = Simulator::Now();
+}
+
+/**
+ * @brief Count an answer to a request sent before (index 0) or after (index 1)
+ * the 4 s DC failure.
+ *
+ * @param trips Round trip state.
+ * @param packet The answer.
+ */
+inline void
+CountDualHomedRoundTrip(DualHomedRoundTrips* trips, Ptr<const Packet> packet)
+{
+    auto it = trips->sent.find(packet->GetUid());
+    if (it == trips->sent.end())
+    {
+        return;
+    }
+    trips->answered[it->second < Seconds(4.0) ? 0 : 1]++;
+    trips->sent.erase(it);
+}
+
+/**
+ * @brief Run N dual-homed branches against two DCs and fail one DC.
+ *
+ * Both DCs serve an echo service on the same address (192.168.100.1 on
+ * their loopback), so a branch is served by whichever DC it routes to. Each
+ * branch sends one request per second from 1 s to 7 s and DC @p failDc goes
+ * down at 4 s. The report compares round trips before and after the
+ * failure and the routing memory with per-destination static tables.
+ *
+ * The function runs and destroys its own simulation, so it must not be
+ * called while another scenario is set up.
+ *
+ * @param branches Number of branches.
+ * @param failDc DC taken down at 4 s (0 or 1).
+ * @param os Stream receiving the report.
+ */
+inline void
+RunDualHomedScenario(uint32_t branches, uint32_t failDc, std::ostream& os)
+{
+    const Ipv4Address service("192.168.100.1");
+    const uint16_t port = 7;
+    auto begin = std::chrono::steady_clock::now();
+
+    NodeContainer dcs;
+    dcs.Create(2);
+    NodeContainer sites;
+    sites.Create(branches);
+    InternetStackHelper stack;
+    stack.Install(dcs);
+    stack.Install(sites);
+
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("5Mbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("2ms"));
+
+    Ptr<DualHomedPlan> plan = Create<DualHomedPlan>(Ipv4Address("10.0.0.0"), branches);
+    Ipv4AddressHelper address;
+    address.SetBase("10.0.0.0", "255.255.255.252");
+    for (uint32_t i = 0; i < branches; ++i)
+    {
+        for (uint32_t dc = 0; dc < 2; ++dc)
+        {
+            // DC first, so it gets .1 as the plan expects
+            address.Assign(p2p.Install(dcs.Get(dc), sites.Get(i)));
+            address.NewNetwork();
+        }
+    }
+    Ipv4AddressHelper interconnect;
+    interconnect.SetBase("192.168.255.0", "255.255.255.252");
+    interconnect.Assign(p2p.Install(dcs.Get(0), dcs.Get(1)));
+
+    for (uint32_t n = 0; n < branches + 2; ++n)
+    {
+        Ptr<Node> node = n < 2 ? dcs.Get(n) : sites.Get(n - 2);
+        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+        Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(ipv4->GetRoutingProtocol());
+        NS_ABORT_MSG_IF(!list, "Dual-homed routing needs the default Ipv4ListRouting");
+        Ptr<DualHomedRouting> routing = CreateObject<DualHomedRouting>();
+        routing->SetRole(plan, n < 2, n < 2 ? n : n - 2);
+        list->AddRoutingProtocol(routing, 10);
+    }
+
+    uint64_t served[2] = {0, 0};
+    for (uint32_t dc = 0; dc < 2; ++dc)
+    {
+        Ptr<Ipv4> ipv4 = dcs.Get(dc)->GetObject<Ipv4>();
+        ipv4->AddAddress(0, Ipv4InterfaceAddress(service, Ipv4Mask("255.255.255.255")));
+        Ptr<AnycastEchoServer> server = CreateObject<AnycastEchoServer>();
+        server->SetAttribute("Local", AddressValue(InetSocketAddress(service, port)));
+        server->TraceConnectWithoutContext("Rx",
+                                           MakeBoundCallback(&CountDualHomedPacket, &served[dc]));
+        dcs.Get(dc)->AddApplication(server);
+        server->SetStartTime(Seconds(0.5));
+    }
+
+    DualHomedRoundTrips trips;
+    UdpEchoClientHelper client(service, port);
+    client.SetAttribute("MaxPackets", UintegerValue(6));
+    client.SetAttribute("Interval", TimeValue(Seconds(1.0)));
+    client.SetAttribute("PacketSize", UintegerValue(64));
+    ApplicationContainer clients = client.Install(sites);
+    for (uint32_t i = 0; i < clients.GetN(); ++i)
+    {
+        clients.Get(i)->TraceConnectWithoutContext(
+            "Tx",
+            MakeBoundCallback(&RecordDualHomedRequest, &trips));
+        clients.Get(i)->TraceConnectWithoutContext(
+            "Rx",
+            MakeBoundCallback(&CountDualHomedRoundTrip, &trips));
+        // Spread the requests over the first second
+        clients.Get(i)->SetStartTime(Seconds(1.0) + MicroSeconds(1000000ULL * i / branches));
+    }
+
+    Simulator::Schedule(Seconds(4.0), &FailDataCenter, plan, failDc, dcs.Get(failDc));
+    Simulator::Stop(Seconds(8.0));
+    auto built = std::chrono::steady_clock::now();
+    Simulator::Run();
+    auto end = std::chrono::steady_clock::now();
+
+    // Every branch sends 3 requests before the failure (1 s, 2 s, 3 s) and 3 after it
+    uint64_t expected = 3 * uint64_t(branches);
+    size_t shared = sizeof(DualHomedPlan) + (branches + 2) * sizeof(DualHomedRouting);
+    size_t flat = size_t(branches + 2) * (2 * branches + 1) * sizeof(Ipv4RoutingTableEntry);
+    os << "Dual-homed design: " << branches << " branches, DC " << failDc
+       << " fails at 4 s\n";
+    os << "Round trips of requests sent before the failure: " << trips.answered[0] << " of "
+       << expected << "\n";
+    os << "Round trips of requests sent after the failure: " << trips.answered[1] << " of "
+       << expected << "\n";
+    os << "Requests served by DC 0: " << served[0] << ", DC 1: " << served[1] << "\n";
+    os << "Routing state: " << shared << " bytes shared vs " << flat
+       << " bytes of per-destination static routes\n";
+    os << "Build " << std::chrono::duration<double, std::milli>(built - begin).count()
+       << " ms, run " << std::chrono::duration<double, std::milli>(end - built).count()
+       << " ms\n";
+
+    Simulator::Destroy();
+}
+
+} // namespace ns3
+
+#endif /* WAN_DUAL_HOMED_H */
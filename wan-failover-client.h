@@ -0,0 +1,517 @@
+#ifndef WAN_FAILOVER_CLIENT_H
+#define WAN_FAILOVER_CLIENT_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Hashed timing wheel shared by many applications.
+ *
+ * Deadlines are rounded up to the next tick and kept in a ring of slots;
+ * one simulator event serves every timer due in a tick. The event only
+ * runs on ticks that have timers due: after each one the wheel scans
+ * ahead for the next due tick and sleeps until then, and no event is
+ * scheduled while the wheel is empty. Timers added by a callback join the
+ * running tick chain instead of starting another one. There is no cancel:
+ * owners give their callbacks a generation number and ignore stale ones.
+ */
+class TimerWheel : public SimpleRefCount<TimerWheel>
+{
+  public:
+    /**
+     * @param tick Timer resolution.
+     * @param slots Number of slots (rounded up to a power of two).
+     */
+    TimerWheel(Time tick, uint32_t slots)
+        : m_tick(tick)
+    {
+        uint32_t n = 1;
+        while (n < slots)
+        {
+            n <<= 1;
+        }
+        m_slots.resize(n);
+    }
+
+    /**
+     * @brief Run a callback after a delay, rounded up to the tick.
+     *
+     * @param delay Delay from now.
+     * @param callback Function to run.
+     */
+    void Schedule(Time delay, Callback<void> callback)
+    {
+        uint64_t due = std::max(CurrentTick() + 1, TickOf(Simulator::Now() + delay));
+        m_slots[due & (m_slots.size() - 1)].push_back(Entry{due, std::move(callback)});
+        m_pending++;
+        // The running Tick() is no longer pending but reschedules itself
+        if (m_inTick)
+        {
+            return;
+        }
+        if (!m_event.IsPending())
+        {
+            m_processed = CurrentTick();
+            Arm(due);
+        }
+        else if (due < m_next)
+        {
+            m_event.Cancel();
+            Arm(due);
+        }
+    }
+
+    /// @return Timers waiting to fire.
+    uint64_t GetNPending() const
+    {
+        return m_pending;
+    }
+
+    /// @return Simulator events the wheel has used.
+    uint64_t GetNEvents() const
+    {
+        return m_events;
+    }
+
+    /// @return Timers that have fired.
+    uint64_t GetNFired() const
+    {
+        return m_fired;
+    }
+
+  private:
+    /// A timer in a slot.
+    struct Entry
+    {
+        uint64_t due;            //!< Tick at which to fire
+        Callback<void> callback; //!< Function to run
+    };
+
+    uint64_t TickOf(Time t) const
+    {
+        // Round up so that a timer never fires early
+        return (t.GetTimeStep() + m_tick.GetTimeStep() - 1) / m_tick.GetTimeStep();
+    }
+
+    uint64_t CurrentTick() const
+    {
+        return Simulator::Now().GetTimeStep() / m_tick.GetTimeStep();
+    }
+
+    Time TimeOfTick(uint64_t tick) const
+    {
+        return TimeStep(tick * m_tick.GetTimeStep());
+    }
+
+    void Arm(uint64_t tick)
+    {
+        m_next = tick;
+        m_event = Simulator::Schedule(TimeOfTick(tick) - Simulator::Now(), &TimerWheel::Tick, this);
+        m_events++;
+    }
+
+    /// @return The earliest tick after @p now with a timer due.
+    uint64_t NextDue(uint64_t now) const
+    {
+        uint64_t size = m_slots.size();
+        for (uint64_t t = now + 1; t <= now + size; ++t)
+        {
+            for (const Entry& entry : m_slots[t & (size - 1)])
+            {
+                if (entry.due == t)
+                {
+                    return t;
+                }
+            }
+        }
+        // Nothing within a rotation: take the earliest of the later rounds
+        uint64_t next = UINT64_MAX;
+        for (const std::vector<Entry>& slot : m_slots)
+        {
+            for (const Entry& entry : slot)
+            {
+                next = std::min(next, entry.due);
+            }
+        }
+        return next;
+    }
+
+    void Tick()
+    {
+        uint64_t now = CurrentTick();
+        NS_ASSERT_MSG(now > m_lastRun, "TimerWheel ran two events in one tick");
+        m_lastRun = now;
+        m_inTick = true;
+        // Every slot is visited once at most, however long the wheel slept
+        uint64_t first =
+            std::max(m_processed + 1, now + 1 - std::min<uint64_t>(now, m_slots.size()));
+        for (uint64_t t = first; t <= now; ++t)
+        {
+            // Callbacks may add timers to this very slot
+            std::vector<Entry> slot;
+            slot.swap(m_slots[t & (m_slots.size() - 1)]);
+            for (Entry& entry : slot)
+            {
+                if (entry.due > t)
+                {
+                    m_slots[t & (m_slots.size() - 1)].push_back(std::move(entry));
+                    continue;
+                }
+                m_pending--;
+                m_fired++;
+                entry.callback();
+            }
+        }
+        m_processed = now;
+        m_inTick = false;
+        if (m_pending > 0)
+        {
+            Arm(NextDue(now));
+        }
+    }
+
+    Time m_tick;                              //!< Resolution
+    std::vector<std::vector<Entry>> m_slots;  //!< Timers by due tick modulo size
+    uint64_t m_processed{0};                  //!< Last tick handled
+    uint64_t m_next{0};                       //!< Tick of the scheduled event
+    uint64_t m_lastRun{0};                    //!< Tick of the last Tick() event
+    bool m_inTick{false};                     //!< True while callbacks run
+    uint64_t m_pending{0};                    //!< Timers not yet fired
+    uint64_t m_events{0};                     //!< Simulator events scheduled
+    uint64_t m_fired{0};                      //!< Timers fired
+    EventId m_event;                          //!< Next tick
+};
+
+/**
+ * @brief UDP echo client that fails over between several server addresses.
+ *
+ * Requests go to the first healthy server in the configured order. Each
+ * server has an RFC 6298 style retransmission timeout from its own RTT
+ * samples. A request that times out marks its server unhealthy and is
+ * retried at once on the next healthy one; unhealthy servers are probed
+ * every HealthInterval and preferred again as soon as a probe is answered.
+ *
+ * All timers live on a TimerWheel that may be shared by many clients.
+ * Requests carry a SeqTsHeader, which UdpEchoServer reflects unchanged.
+ */
+class FailoverEchoClient : public Application
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::FailoverEchoClient")
+                .SetParent<Application>()
+                .AddConstructor<FailoverEchoClient>()
+                .AddAttribute("Interval",
+                              "Time between requests.",
+                              TimeValue(Seconds(1.0)),
+                              MakeTimeAccessor(&FailoverEchoClient::m_interval),
+                              MakeTimeChecker())
+                .AddAttribute("PacketSize",
+                              "Request size in bytes (at least the SeqTsHeader).",
+                              UintegerValue(64),
+                              MakeUintegerAccessor(&FailoverEchoClient::m_size),
+                              MakeUintegerChecker<uint32_t>())
+                .AddAttribute("MinTimeout",
+                              "Lower bound of the adaptive timeout.",
+                              TimeValue(MilliSeconds(50)),
+                              MakeTimeAccessor(&FailoverEchoClient::m_minTimeout),
+                              MakeTimeChecker())
+                .AddAttribute("MaxTimeout",
+                              "Upper bound of the adaptive timeout, also used before any sample.",
+                              TimeValue(Seconds(1.0)),
+                              MakeTimeAccessor(&FailoverEchoClient::m_maxTimeout),
+                              MakeTimeChecker())
+                .AddAttribute("HealthInterval",
+                              "Time between probes of an unhealthy server.",
+                              TimeValue(MilliSeconds(500)),
+                              MakeTimeAccessor(&FailoverEchoClient::m_healthInterval),
+                              MakeTimeChecker());
+        return tid;
+    }
+
+    /// @param wheel Timer wheel to schedule on.
+    void SetTimerWheel(Ptr<TimerWheel> wheel)
+    {
+        m_wheel = wheel;
+    }
+
+    /**
+     * @brief Add a server; earlier servers are preferred.
+     *
+     * @param address Server address and port.
+     * @param device Device to pin the requests to, or nullptr to follow routing.
+     */
+    void AddServer(InetSocketAddress address, Ptr<NetDevice> device = nullptr)
+    {
+        Server server;
+        server.address = address;
+        server.device = device;
+        m_servers.push_back(server);
+    }
+
+    /// Counters of one client, summed over its servers.
+    struct Stats
+    {
+        uint64_t sent{0};          //!< Requests sent, retries included
+        uint64_t answered{0};      //!< Requests answered
+        uint64_t timeouts{0};      //!< Requests timed out
+        uint64_t failovers{0};     //!< Switches of the preferred server
+        Time outage;               //!< Longest time without any answer while running
+    };
+
+    /// @return The counters of this client.
+    const Stats& GetStats() const
+    {
+        return m_stats;
+    }
+
+    /**
+     * @brief Write per-server counters and timeouts.
+     *
+     * @param os Output stream.
+     */
+    void Print(std::ostream& os) const
+    {
+        for (const Server& s : m_servers)
+        {
+            os << "  " << s.address.GetIpv4() << ": " << s.answered << " answered, " << s.lost
+               << " lost, timeout " << Timeout(s).As(Time::MS)
+               << (s.healthy ? "" : " (unhealthy)") << "\n";
+        }
+    }
+
+  private:
+    /// State of one server address.
+    struct Server
+    {
+        InetSocketAddress address{Ipv4Address::GetAny(), 0}; //!< Address and port
+        Ptr<NetDevice> device;                               //!< Pinned device
+        Ptr<Socket> socket;                                  //!< UDP socket
+        Time srtt;                                           //!< Smoothed RTT
+        Time rttvar;                                         //!< RTT variation
+        bool sampled{false};                                 //!< True after the first RTT
+        bool healthy{true};                                  //!< Preferred while healthy
+        uint64_t answered{0};                                //!< Answered requests
+        uint64_t lost{0};                                    //!< Timed-out requests
+    };
+
+    /// An unanswered request or probe.
+    struct Pending
+    {
+        uint32_t server; //!< Server index
+        bool probe;      //!< True for a health probe
+    };
+
+    void StartApplication() override
+    {
+        NS_ABORT_MSG_IF(!m_wheel, "FailoverEchoClient needs a TimerWheel");
+        NS_ABORT_MSG_IF(m_servers.empty(), "FailoverEchoClient needs a server");
+        m_running = true;
+        m_lastAnswer = Simulator::Now();
+        for (Server& s : m_servers)
+        {
+            s.socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+            s.socket->Bind();
+            if (s.device)
+            {
+                s.socket->BindToNetDevice(s.device);
+            }
+            s.socket->SetRecvCallback(MakeCallback(&FailoverEchoClient::HandleRead, this));
+        }
+        SendRequest();
+    }
+
+    void StopApplication() override
+    {
+        m_running = false;
+        m_stats.outage = std::max(m_stats.outage, Simulator::Now() - m_lastAnswer);
+        for (Server& s : m_servers)
+        {
+            s.socket->Close();
+            s.socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+        }
+    }
+
+    Time Timeout(const Server& s) const
+    {
+        if (!s.sampled)
+        {
+            return m_maxTimeout;
+        }
+        return std::min(m_maxTimeout, std::max(m_minTimeout, s.srtt + 4 * s.rttvar));
+    }
+
+    /// @return The first healthy server, or the first one if none is healthy.
+    uint32_t Preferred() const
+    {
+        for (uint32_t i = 0; i < m_servers.size(); ++i)
+        {
+            if (m_servers[i].healthy)
+            {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    void Send(uint32_t index, bool probe)
+    {
+        Server& s = m_servers[index];
+        uint32_t seq = m_seq++;
+        SeqTsHeader header;
+        header.SetSeq(seq);
+        uint32_t headerSize = header.GetSerializedSize();
+        Ptr<Packet> packet = Create<Packet>(m_size > headerSize ? m_size - headerSize : 0);
+        packet->AddHeader(header);
+        s.socket->SendTo(packet, 0, s.address);
+        m_pending[seq] = Pending{index, probe};
+        m_stats.sent += probe ? 0 : 1;
+        m_wheel->Schedule(Timeout(s),
+                          MakeCallback(&FailoverEchoClient::Expire, this).Bind(seq));
+    }
+
+    void SendRequest()
+    {
+        if (!m_running)
+        {
+            return;
+        }
+        Send(Preferred(), false);
+        m_wheel->Schedule(m_interval, MakeCallback(&FailoverEchoClient::SendRequest, this));
+    }
+
+    void Probe(uint32_t index)
+    {
+        if (!m_running || m_servers[index].healthy)
+        {
+            m_probing[index] = false;
+            return;
+        }
+        Send(index, true);
+        m_wheel->Schedule(m_healthInterval,
+                          MakeCallback(&FailoverEchoClient::Probe, this).Bind(index));
+    }
+
+    void SetHealthy(uint32_t index, bool healthy)
+    {
+        uint32_t before = Preferred();
+        m_servers[index].healthy = healthy;
+        if (Preferred() != before)
+        {
+            m_stats.failovers++;
+        }
+        if (!healthy && !m_probing[index])
+        {
+            m_probing[index] = true;
+            m_wheel->Schedule(m_healthInterval,
+                              MakeCallback(&FailoverEchoClient::Probe, this).Bind(index));
+        }
+    }
+
+    void Expire(uint32_t seq)
+    {
+        auto it = m_pending.find(seq);
+        if (it == m_pending.end() || !m_running)
+        {
+            return;
+        }
+        Pending pending = it->second;
+        m_pending.erase(it);
+        if (pending.probe)
+        {
+            return;
+        }
+        m_stats.timeouts++;
+        m_servers[pending.server].lost++;
+        bool wasHealthy = m_servers[pending.server].healthy;
+        SetHealthy(pending.server, false);
+        // Fast retry on the alternate address instead of waiting for the next interval
+        uint32_t next = Preferred();
+        if (wasHealthy && m_servers[next].healthy)
+        {
+            Send(next, false);
+        }
+    }
+
+    void HandleRead(Ptr<Socket> socket)
+    {
+        Ptr<Packet> packet;
+        Address from;
+        while ((packet = socket->RecvFrom(from)))
+        {
+            SeqTsHeader header;
+            if (packet->GetSize() < header.GetSerializedSize())
+            {
+                continue;
+            }
+            packet->RemoveHeader(header);
+            auto it = m_pending.find(header.GetSeq());
+            if (it == m_pending.end())
+            {
+                continue;
+            }
+            Pending pending = it->second;
+            m_pending.erase(it);
+            Server& s = m_servers[pending.server];
+            Time rtt = Simulator::Now() - header.GetTs();
+            if (!s.sampled)
+            {
+                s.srtt = rtt;
+                s.rttvar = rtt / 2;
+                s.sampled = true;
+            }
+            else
+            {
+                Time delta = s.srtt > rtt ? s.srtt - rtt : rtt - s.srtt;
+                s.rttvar = (3 * s.rttvar + delta) / 4;
+                s.srtt = (7 * s.srtt + rtt) / 8;
+            }
+            if (!s.healthy)
+            {
+                SetHealthy(pending.server, true);
+            }
+            if (!pending.probe)
+            {
+                s.answered++;
+                m_stats.answered++;
+                m_stats.outage = std::max(m_stats.outage, Simulator::Now() - m_lastAnswer);
+                m_lastAnswer = Simulator::Now();
+            }
+        }
+    }
+
+    Ptr<TimerWheel> m_wheel;                         //!< Shared timers
+    std::vector<Server> m_servers;                   //!< Servers in preference order
+    std::unordered_map<uint32_t, Pending> m_pending; //!< Unanswered sequence numbers
+    std::unordered_map<uint32_t, bool> m_probing;    //!< Servers with a probe loop running
+    Time m_interval;                                 //!< Time between requests
+    uint32_t m_size{64};                             //!< Request size
+    Time m_minTimeout;                               //!< Timeout lower bound
+    Time m_maxTimeout;                               //!< Timeout upper bound and initial value
+    Time m_healthInterval;                           //!< Probe period of unhealthy servers
+    uint32_t m_seq{0};                               //!< Next sequence number
+    bool m_running{false};                           //!< Between start and stop
+    Time m_lastAnswer;                               //!< Time of the last answer
+    Stats m_stats;                                   //!< Counters
+};
+
+} // namespace ns3
+
+#endif /* WAN_FAILOVER_CLIENT_H */
@@ -0,0 +1,362 @@
+#ifndef WAN_FLOW_EXPORT_H
+#define WAN_FLOW_EXPORT_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Sampled NetFlow-style flow export on the ingress of every router.
+ *
+ * Every node samples one in N received IPv4 packets with a countdown, so an
+ * unsampled packet costs a decrement. Sampled packets are accounted in a
+ * fixed-size open-addressing flow cache per node (linear probing, backward
+ * shift deletion). A flow record is exported when it has been idle for the
+ * inactive timeout, has lived for the active timeout, or is evicted because
+ * its probe window is full. Records are appended to a text collector file;
+ * packet and byte counts are the sampled ones, and the sampling interval is
+ * written in the file header so the collector can scale them.
+ *
+ * The timeout sweep runs on a fixed grid of half the shorter timeout, but
+ * only while some cache holds a flow: an empty sweep changes nothing, so
+ * idle periods are skipped and the next new flow re-arms the sweep at the
+ * following grid point.
+ */
+class FlowExporter : public SimpleRefCount<FlowExporter>
+{
+  public:
+    /// Per-node totals.
+    struct Counters
+    {
+        uint64_t observed{0};  //!< Packets seen on ingress
+        uint64_t sampled{0};   //!< Packets accounted in the cache
+        uint64_t records{0};   //!< Records exported
+        uint64_t evictions{0}; //!< Records exported because the cache was full
+    };
+
+    /**
+     * @param collector Path of the collector file.
+     * @param sampling Sample one packet in this many.
+     * @param cacheSize Flow cache entries per node (rounded up to a power of two).
+     */
+    FlowExporter(const std::string& collector, uint32_t sampling, uint32_t cacheSize)
+        : m_sampling(std::max(1u, sampling)),
+          m_file(collector)
+    {
+        m_capacity = 1;
+        while (m_capacity < cacheSize)
+        {
+            m_capacity <<= 1;
+        }
+        m_file << "# sampling 1/" << m_sampling << "\n"
+               << "# time,exporter,src,dst,proto,sport,dport,tos,packets,bytes,first,last,"
+                  "reason\n";
+    }
+
+    /// @param timeout Idle time after which a flow is exported.
+    void SetInactiveTimeout(Time timeout)
+    {
+        m_inactiveTimeout = timeout;
+    }
+
+    /// @param timeout Lifetime after which a long flow is exported and restarted.
+    void SetActiveTimeout(Time timeout)
+    {
+        m_activeTimeout = timeout;
+    }
+
+    /**
+     * @brief Start sampling on every node and the timeout sweep grid.
+     *
+     * @param nodes Nodes carrying an Ipv4L3Protocol instance.
+     */
+    void Install(NodeContainer nodes)
+    {
+        for (uint32_t i = 0; i < nodes.GetN(); ++i)
+        {
+            Ptr<Ipv4L3Protocol> ipv4 = nodes.Get(i)->GetObject<Ipv4L3Protocol>();
+            NS_ASSERT_MSG(ipv4, "FlowExporter requires an installed Internet stack");
+            m_caches.emplace_back();
+            Cache& cache = m_caches.back();
+            cache.nodeId = nodes.Get(i)->GetId();
+            cache.entries.resize(m_capacity);
+            cache.countdown = m_sampling;
+            ipv4->TraceConnectWithoutContext(
+                "Rx",
+                MakeBoundCallback(&FlowExporter::RxTrace, this, uint32_t(m_caches.size() - 1)));
+        }
+        m_sweepOrigin = Simulator::Now();
+    }
+
+    /**
+     * @brief Export every remaining flow and stop the sweep.
+     *
+     * Call after Simulator::Run().
+     */
+    void Flush()
+    {
+        m_sweep.Cancel();
+        for (Cache& cache : m_caches)
+        {
+            for (Entry& e : cache.entries)
+            {
+                if (e.used)
+                {
+                    Export(cache, e, "end");
+                    e.used = false;
+                }
+            }
+        }
+        m_flows = 0;
+        m_file.flush();
+    }
+
+    /**
+     * @brief Write per-node counters.
+     *
+     * @param os Output stream.
+     */
+    void Print(std::ostream& os) const
+    {
+        os << "Node  Observed  Sampled  Records  Evictions\n";
+        for (const Cache& cache : m_caches)
+        {
+            const Counters& c = cache.counters;
+            os << "n" << cache.nodeId << "    " << c.observed << "  " << c.sampled << "  "
+               << c.records << "  " << c.evictions << "\n";
+        }
+    }
+
+  private:
+    /// Longest run of slots probed before evicting.
+    static constexpr uint32_t MAX_PROBE = 16;
+
+    /// Flow key: the 5-tuple plus ToS.
+    struct Key
+    {
+        uint32_t src{0};   //!< Source address
+        uint32_t dst{0};   //!< Destination address
+        uint16_t sport{0}; //!< Source port
+        uint16_t dport{0}; //!< Destination port
+        uint8_t proto{0};  //!< IP protocol
+        uint8_t tos{0};    //!< Type of service
+
+        bool operator==(const Key& o) const
+        {
+            return src == o.src && dst == o.dst && sport == o.sport && dport == o.dport &&
+                   proto == o.proto && tos == o.tos;
+        }
+    };
+
+    /// Flow cache slot.
+    struct Entry
+    {
+        Key key;             //!< Flow key
+        uint64_t packets{0}; //!< Sampled packets
+        uint64_t bytes{0};   //!< Sampled bytes
+        Time first;          //!< First sampled packet
+        Time last;           //!< Last sampled packet
+        bool used{false};    //!< Slot holds a flow
+    };
+
+    /// Flow cache and sampler of one node.
+    struct Cache
+    {
+        uint32_t nodeId{0};         //!< Node id
+        std::vector<Entry> entries; //!< Open-addressing table
+        uint32_t countdown{1};      //!< Packets until the next sample
+        Counters counters;          //!< Totals
+    };
+
+    Time SweepInterval() const
+    {
+        return std::min(m_inactiveTimeout, m_activeTimeout) / 2;
+    }
+
+    uint32_t Slot(const Key& k) const
+    {
+        uint64_t h = (uint64_t(k.src) << 32 | k.dst) * 0x9e3779b97f4a7c15ULL;
+        uint64_t ports = uint64_t(k.sport) << 24 | uint64_t(k.dport) << 8 | k.proto;
+        h ^= ports * 0xc2b2ae3d27d4eb4fULL;
+        h ^= k.tos;
+        return uint32_t(h >> 32) & (m_capacity - 1);
+    }
+
+    static void RxTrace(FlowExporter* self,
+                        uint32_t index,
+                        Ptr<const Packet> packet,
+                        Ptr<Ipv4> ipv4,
+                        uint32_t interface)
+    {
+        Cache& cache = self->m_caches[index];
+        cache.counters.observed++;
+        if (--cache.countdown > 0)
+        {
+            return;
+        }
+        cache.countdown = self->m_sampling;
+        self->Account(cache, packet);
+    }
+
+    void Account(Cache& cache, Ptr<const Packet> packet)
+    {
+        Ipv4Header ip;
+        packet->PeekHeader(ip);
+        Key key;
+        key.src = ip.GetSource().Get();
+        key.dst = ip.GetDestination().Get();
+        key.proto = ip.GetProtocol();
+        key.tos = ip.GetTos();
+        // Ports are only in the first fragment
+        if (ip.GetFragmentOffset() == 0 &&
+            (key.proto == UdpL4Protocol::PROT_NUMBER || key.proto == TcpL4Protocol::PROT_NUMBER))
+        {
+            uint8_t ports[4];
+            if (packet->GetSize() >= ip.GetSerializedSize() + 4)
+            {
+                Ptr<Packet> payload = packet->Copy();
+                payload->RemoveHeader(ip);
+                payload->CopyData(ports, 4);
+                key.sport = uint16_t(ports[0] << 8 | ports[1]);
+                key.dport = uint16_t(ports[2] << 8 | ports[3]);
+            }
+        }
+        cache.counters.sampled++;
+
+        Time now = Simulator::Now();
+        uint32_t mask = m_capacity - 1;
+        uint32_t home = Slot(key);
+        uint32_t oldest = home;
+        for (uint32_t probe = 0; probe < MAX_PROBE; ++probe)
+        {
+            uint32_t i = (home + probe) & mask;
+            Entry& e = cache.entries[i];
+            if (!e.used)
+            {
+                e.key = key;
+                e.packets = 0;
+                e.bytes = 0;
+                e.first = now;
+                e.used = true;
+                m_flows++;
+                if (!m_sweep.IsPending())
+                {
+                    int64_t step = SweepInterval().GetTimeStep();
+                    int64_t done = (now - m_sweepOrigin).GetTimeStep() / step;
+                    Time next = m_sweepOrigin + TimeStep((done + 1) * step);
+                    m_sweep = Simulator::Schedule(next - now, &FlowExporter::Sweep, this);
+                }
+            }
+            if (e.key == key)
+            {
+                e.packets++;
+                e.bytes += ip.GetPayloadSize() + ip.GetSerializedSize();
+                e.last = now;
+                return;
+            }
+            if (e.last < cache.entries[oldest].last)
+            {
+                oldest = i;
+            }
+        }
+        // Probe window full: export the stalest flow and take its place
+        Entry& victim = cache.entries[oldest];
+        Export(cache, victim, "full");
+        cache.counters.evictions++;
+        victim.key = key;
+        victim.packets = 1;
+        victim.bytes = ip.GetPayloadSize() + ip.GetSerializedSize();
+        victim.first = now;
+        victim.last = now;
+    }
+
+    void Export(Cache& cache, const Entry& e, const char* reason)
+    {
+        m_file << Simulator::Now().GetSeconds() << ",n" << cache.nodeId << ","
+               << Ipv4Address(e.key.src) << "," << Ipv4Address(e.key.dst) << ","
+               << uint32_t(e.key.proto) << "," << e.key.sport << "," << e.key.dport << ","
+               << uint32_t(e.key.tos) << "," << e.packets << "," << e.bytes << ","
+               << e.first.GetSeconds() << "," << e.last.GetSeconds() << "," << reason << "\n";
+        cache.counters.records++;
+    }
+
+    /// Remove slot @p hole and shift later members of its cluster back.
+    void Erase(Cache& cache, uint32_t hole)
+    {
+        uint32_t mask = m_capacity - 1;
+        uint32_t i = hole;
+        while (true)
+        {
+            i = (i + 1) & mask;
+            Entry& e = cache.entries[i];
+            if (!e.used)
+            {
+                break;
+            }
+            // Move e back if its home slot is not cyclically in (hole, i]
+            uint32_t home = Slot(e.key);
+            if (((i - home) & mask) >= ((i - hole) & mask))
+            {
+                cache.entries[hole] = e;
+                hole = i;
+            }
+        }
+        cache.entries[hole].used = false;
+        m_flows--;
+    }
+
+    void Sweep()
+    {
+        Time now = Simulator::Now();
+        for (Cache& cache : m_caches)
+        {
+            uint32_t i = 0;
+            while (i < m_capacity)
+            {
+                Entry& e = cache.entries[i];
+                if (e.used && now - e.last >= m_inactiveTimeout)
+                {
+                    Export(cache, e, "inactive");
+                    // Erase may shift another flow into slot i
+                    Erase(cache, i);
+                    continue;
+                }
+                if (e.used && now - e.first >= m_activeTimeout)
+                {
+                    Export(cache, e, "active");
+                    e.packets = 0;
+                    e.bytes = 0;
+                    e.first = now;
+                }
+                ++i;
+            }
+        }
+        if (m_flows > 0)
+        {
+            m_sweep = Simulator::Schedule(SweepInterval(), &FlowExporter::Sweep, this);
+        }
+    }
+
+    uint32_t m_sampling;                 //!< Sample one packet in this many
+    uint32_t m_capacity{1};              //!< Entries per cache
+    Time m_inactiveTimeout{Seconds(15)}; //!< Idle export threshold
+    Time m_activeTimeout{Seconds(60)};   //!< Long-lived export threshold
+    std::vector<Cache> m_caches;         //!< One cache per node
+    std::ofstream m_file;                //!< Collector file
+    EventId m_sweep;                     //!< Next timeout sweep, if any flow is cached
+    Time m_sweepOrigin;                  //!< Start of the sweep grid
+    uint64_t m_flows{0};                 //!< Flows in all caches
+};
+
+} // namespace ns3
+
+#endif /* WAN_FLOW_EXPORT_H */
@@ -0,0 +1,262 @@
+#ifndef WAN_FORWARDING_ENGINE_H
+#define WAN_FORWARDING_ENGINE_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <deque>
+#include <ostream>
+
+namespace ns3
+{
+
+/**
+ * @brief Finite forwarding capacity of a router.
+ *
+ * Sits in front of every other protocol of the node's Ipv4ListRouting and
+ * takes each transit packet into a bounded ingress queue (tail drop, seen
+ * as DROP_ROUTE_ERROR in the Ipv4L3Protocol Drop trace). The forwarding
+ * CPU serves the queue at Pps packets per second, minus the share
+ * currently taken by the control plane, and hands served packets back to
+ * the routing list. Service is done in batches of up to MaxBatch packets
+ * with one simulator event per batch, so a packet leaves at the end of its
+ * batch rather than at its own service time.
+ */
+class Ipv4ForwardingEngine : public Ipv4RoutingProtocol
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::Ipv4ForwardingEngine")
+                .SetParent<Ipv4RoutingProtocol>()
+                .AddConstructor<Ipv4ForwardingEngine>()
+                .AddAttribute("Pps",
+                              "Forwarding capacity with an idle control plane.",
+                              DoubleValue(10000),
+                              MakeDoubleAccessor(&Ipv4ForwardingEngine::m_pps),
+                              MakeDoubleChecker<double>(1))
+                .AddAttribute("QueueSize",
+                              "Ingress queue limit in packets.",
+                              UintegerValue(100),
+                              MakeUintegerAccessor(&Ipv4ForwardingEngine::m_queueSize),
+                              MakeUintegerChecker<uint32_t>(1))
+                .AddAttribute("MaxBatch",
+                              "Packets served per simulator event.",
+                              UintegerValue(32),
+                              MakeUintegerAccessor(&Ipv4ForwardingEngine::m_maxBatch),
+                              MakeUintegerChecker<uint32_t>(1))
+                .AddAttribute("ControlPlaneShare",
+                              "Fraction of the CPU taken by the control plane.",
+                              DoubleValue(0.0),
+                              MakeDoubleAccessor(&Ipv4ForwardingEngine::m_controlShare),
+                              MakeDoubleChecker<double>(0, 0.99));
+        return tid;
+    }
+
+    /**
+     * @brief Change the control-plane load, e.g. during reconvergence.
+     *
+     * Takes effect from the next batch.
+     *
+     * @param share Fraction of the CPU, 0 to 0.99.
+     */
+    void SetControlPlaneShare(double share)
+    {
+        m_controlShare = std::min(std::max(share, 0.0), 0.99);
+    }
+
+    /**
+     * @brief Write forwarding counters.
+     *
+     * @param os Output stream.
+     */
+    void Print(std::ostream& os) const
+    {
+        os << "Forwarded " << m_forwarded << ", dropped " << m_dropped << " at ingress, "
+           << m_batches << " batches, peak queue " << m_peakQueue << "\n";
+        if (m_forwarded > 0)
+        {
+            os << "Mean queueing delay "
+               << (m_totalDelay / int64_t(m_forwarded)).As(Time::US) << "\n";
+        }
+    }
+
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                               const Ipv4Header& header,
+                               Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override
+    {
+        // Locally originated traffic is not charged to the forwarding CPU
+        sockerr = Socket::ERROR_NOROUTETOHOST;
+        return nullptr;
+    }
+
+    bool RouteInput(Ptr<const Packet> p,
+                    const Ipv4Header& header,
+                    Ptr<const NetDevice> idev,
+                    const UnicastForwardCallback& ucb,
+                    const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb,
+                    const ErrorCallback& ecb) override
+    {
+        Ipv4Address dest = header.GetDestination();
+        if (m_serving || dest.IsMulticast() || dest.IsBroadcast() ||
+            m_ipv4->IsDestinationAddress(dest, m_ipv4->GetInterfaceForDevice(idev)))
+        {
+            return false;
+        }
+        if (m_queue.size() >= m_queueSize)
+        {
+            // Through the error callback, so the drop shows in the Ipv4L3Protocol Drop trace
+            m_dropped++;
+            ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+            return true;
+        }
+        m_queue.push_back(Item{p, header, idev, ucb, mcb, lcb, ecb, Simulator::Now()});
+        m_peakQueue = std::max<uint64_t>(m_peakQueue, m_queue.size());
+        if (!m_batchEvent.IsPending())
+        {
+            StartBatch();
+        }
+        return true;
+    }
+
+    void NotifyInterfaceUp(uint32_t interface) override
+    {
+    }
+
+    void NotifyInterfaceDown(uint32_t interface) override
+    {
+    }
+
+    void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void SetIpv4(Ptr<Ipv4> ipv4) override
+    {
+        m_ipv4 = ipv4;
+    }
+
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+                           Time::Unit unit = Time::S) const override
+    {
+        *stream->GetStream() << "Forwarding engine: " << m_pps << " pps, control plane "
+                             << m_controlShare * 100 << "%, queue " << m_queue.size() << "/"
+                             << m_queueSize << "\n";
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_batchEvent.Cancel();
+        m_queue.clear();
+        m_ipv4 = nullptr;
+        Ipv4RoutingProtocol::DoDispose();
+    }
+
+  private:
+    /// A transit packet waiting for the CPU.
+    struct Item
+    {
+        Ptr<const Packet> packet;     //!< Packet
+        Ipv4Header header;            //!< Its IPv4 header
+        Ptr<const NetDevice> idev;    //!< Input device
+        UnicastForwardCallback ucb;   //!< Unicast forward callback
+        MulticastForwardCallback mcb; //!< Multicast forward callback
+        LocalDeliverCallback lcb;     //!< Local delivery callback
+        ErrorCallback ecb;            //!< Error callback
+        Time arrival;                 //!< Enqueue time
+    };
+
+    void StartBatch()
+    {
+        m_batch = std::min<uint32_t>(m_queue.size(), m_maxBatch);
+        double rate = m_pps * (1 - m_controlShare);
+        m_batchEvent = Simulator::Schedule(Seconds(m_batch / rate),
+                                           &Ipv4ForwardingEngine::FinishBatch,
+                                           this);
+        m_batches++;
+    }
+
+    void FinishBatch()
+    {
+        Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(m_ipv4->GetRoutingProtocol());
+        Time now = Simulator::Now();
+        // The rest of the list routes the packet; RouteInput lets it through meanwhile
+        m_serving = true;
+        for (uint32_t i = 0; i < m_batch; ++i)
+        {
+            Item item = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_totalDelay += now - item.arrival;
+            m_forwarded++;
+            if (!list->RouteInput(item.packet,
+                                  item.header,
+                                  item.idev,
+                                  item.ucb,
+                                  item.mcb,
+                                  item.lcb,
+                                  item.ecb))
+            {
+                item.ecb(item.packet, item.header, Socket::ERROR_NOROUTETOHOST);
+            }
+        }
+        m_serving = false;
+        if (!m_queue.empty())
+        {
+            StartBatch();
+        }
+    }
+
+    Ptr<Ipv4> m_ipv4;          //!< IPv4 of the router
+    double m_pps{10000};       //!< Capacity with an idle control plane
+    uint32_t m_queueSize{100}; //!< Ingress queue limit
+    uint32_t m_maxBatch{32};   //!< Packets per batch
+    double m_controlShare{0};  //!< CPU share of the control plane
+    std::deque<Item> m_queue;  //!< Ingress queue
+    uint32_t m_batch{0};       //!< Size of the batch in service
+    bool m_serving{false};     //!< True while handing a batch back to the list
+    EventId m_batchEvent;      //!< End of the batch in service
+    uint64_t m_forwarded{0};   //!< Packets served
+    uint64_t m_dropped{0};     //!< Packets dropped at ingress
+    uint64_t m_batches{0};     //!< Batches (simulator events)
+    uint64_t m_peakQueue{0};   //!< Longest queue seen
+    Time m_totalDelay;         //!< Sum of queueing delays
+};
+
+/**
+ * @brief Put an Ipv4ForwardingEngine in front of all routing of a node.
+ *
+ * @param node Node with an installed Internet stack.
+ * @param pps Forwarding capacity in packets per second.
+ * @param queueSize Ingress queue limit in packets.
+ * @return The engine.
+ */
+inline Ptr<Ipv4ForwardingEngine>
+InstallForwardingEngine(Ptr<Node> node, double pps, uint32_t queueSize)
+{
+    Ptr<Ipv4ListRouting> list =
+        DynamicCast<Ipv4ListRouting>(node->GetObject<Ipv4>()->GetRoutingProtocol());
+    NS_ABORT_MSG_IF(!list, "The forwarding engine needs the default Ipv4ListRouting");
+    Ptr<Ipv4ForwardingEngine> engine = CreateObject<Ipv4ForwardingEngine>();
+    engine->SetAttribute("Pps", DoubleValue(pps));
+    engine->SetAttribute("QueueSize", UintegerValue(queueSize));
+    list->AddRoutingProtocol(engine, 20);
+    return engine;
+}
+
+} // namespace ns3
+
+#endif /* WAN_FORWARDING_ENGINE_H */
@@ -0,0 +1,201 @@
+#ifndef WAN_FRAGMENTATION_STATS_H
+#define WAN_FRAGMENTATION_STATS_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <map>
+#include <ostream>
+#include <set>
+#include <tuple>
+
+namespace ns3
+{
+
+/**
+ * @brief Per-node IPv4 fragmentation and reassembly counters.
+ *
+ * Fragmentation and reassembly are done by Ipv4L3Protocol itself: it keeps
+ * the received fragments as a list of Ptr<Packet> keyed by offset and joins
+ * them once the datagram is complete, so no fragment payload is copied until
+ * the final packet is built. This class only listens to the Tx, Rx and Drop
+ * traces of each node's Ipv4L3Protocol and counts what happened.
+ *
+ * Fragmentation is counted for datagrams the node originates, not for
+ * fragments it only forwards. A delivered datagram counts as reassembled
+ * when fragments with its source, destination, protocol and identification
+ * were received, wherever along the path it was fragmented.
+ */
+class FragmentationStats
+{
+  public:
+    /// Counters collected for one node.
+    struct NodeCounters
+    {
+        uint64_t datagramsFragmented{0}; //!< Local datagrams split on transmit
+        uint64_t fragmentsSent{0};       //!< Their fragments handed to a device
+        uint64_t fragmentsReceived{0};   //!< Fragments received on any interface
+        uint64_t datagramsReassembled{0}; //!< Fragmented datagrams delivered locally
+        uint64_t reassemblyTimeouts{0};  //!< Datagrams dropped by the expiration timer
+        Time firstFragment{Seconds(0)};  //!< Time of the first fragment sent
+        Time lastFragment{Seconds(0)};   //!< Time of the last fragment sent
+    };
+
+    /**
+     * @brief Connect the counters to the IPv4 traces of every node.
+     *
+     * @param nodes Nodes carrying an Ipv4L3Protocol instance.
+     */
+    void Install(NodeContainer nodes)
+    {
+        for (uint32_t i = 0; i < nodes.GetN(); ++i)
+        {
+            Ptr<Node> node = nodes.Get(i);
+            Ptr<Ipv4L3Protocol> ipv4 = node->GetObject<Ipv4L3Protocol>();
+            NS_ASSERT_MSG(ipv4, "FragmentationStats requires an installed Internet stack");
+            uint32_t id = node->GetId();
+            m_counters[id] = NodeCounters();
+            ipv4->TraceConnectWithoutContext(
+                "Tx",
+                MakeBoundCallback(&FragmentationStats::TxTrace, this, id));
+            ipv4->TraceConnectWithoutContext(
+                "Rx",
+                MakeBoundCallback(&FragmentationStats::RxTrace, this, id));
+            ipv4->TraceConnectWithoutContext(
+                "LocalDeliver",
+                MakeBoundCallback(&FragmentationStats::LocalDeliverTrace, this, id));
+            ipv4->TraceConnectWithoutContext(
+                "Drop",
+                MakeBoundCallback(&FragmentationStats::DropTrace, this, id));
+        }
+    }
+
+    /**
+     * @brief Write a per-node summary, including the fragment send rate.
+     *
+     * @param os Output stream.
+     */
+    void Print(std::ostream& os) const
+    {
+        os << "Node  Fragmented  FragTx  FragRx  Reassembled  Timeouts  FragTx/s\n";
+        for (const auto& entry : m_counters)
+        {
+            const NodeCounters& c = entry.second;
+            double active = (c.lastFragment - c.firstFragment).GetSeconds();
+            double rate = active > 0 ? c.fragmentsSent / active : 0.0;
+            os << "n" << entry.first << "    " << c.datagramsFragmented << "  "
+               << c.fragmentsSent << "  " << c.fragmentsReceived << "  "
+               << c.datagramsReassembled << "  " << c.reassemblyTimeouts << "  " << rate
+               << "\n";
+        }
+    }
+
+    /**
+     * @param nodeId Node identifier.
+     * @return The counters of the node (zero if it was never installed).
+     */
+    NodeCounters Get(uint32_t nodeId) const
+    {
+        auto it = m_counters.find(nodeId);
+        return it == m_counters.end() ? NodeCounters() : it->second;
+    }
+
+  private:
+    /// Reassembly key used by Ipv4L3Protocol: source, destination, protocol, identification.
+    using FragmentKey = std::tuple<uint32_t, uint32_t, uint8_t, uint16_t>;
+
+    static bool IsFragment(const Ipv4Header& header)
+    {
+        return !header.IsLastFragment() || header.GetFragmentOffset() != 0;
+    }
+
+    static FragmentKey Key(const Ipv4Header& header)
+    {
+        return FragmentKey(header.GetSource().Get(),
+                           header.GetDestination().Get(),
+                           header.GetProtocol(),
+                           header.GetIdentification());
+    }
+
+    static void TxTrace(FragmentationStats* self,
+                        uint32_t nodeId,
+                        Ptr<const Packet> packet,
+                        Ptr<Ipv4> ipv4,
+                        uint32_t interface)
+    {
+        Ipv4Header header;
+        packet->PeekHeader(header);
+        // Fragments only forwarded by this node were split upstream
+        if (!IsFragment(header) || ipv4->GetInterfaceForAddress(header.GetSource()) < 0)
+        {
+            return;
+        }
+        NodeCounters& c = self->m_counters[nodeId];
+        if (c.fragmentsSent == 0)
+        {
+            c.firstFragment = Simulator::Now();
+        }
+        c.lastFragment = Simulator::Now();
+        c.fragmentsSent++;
+        if (header.GetFragmentOffset() == 0)
+        {
+            c.datagramsFragmented++;
+        }
+    }
+
+    static void RxTrace(FragmentationStats* self,
+                        uint32_t nodeId,
+                        Ptr<const Packet> packet,
+                        Ptr<Ipv4> ipv4,
+                        uint32_t interface)
+    {
+        Ipv4Header header;
+        packet->PeekHeader(header);
+        if (!IsFragment(header))
+        {
+            return;
+        }
+        self->m_counters[nodeId].fragmentsReceived++;
+        if (ipv4->GetInterfaceForAddress(header.GetDestination()) >= 0)
+        {
+            self->m_reassembling[nodeId].insert(Key(header));
+        }
+    }
+
+    static void LocalDeliverTrace(FragmentationStats* self,
+                                  uint32_t nodeId,
+                                  const Ipv4Header& header,
+                                  Ptr<const Packet> packet,
+                                  uint32_t interface)
+    {
+        // Ipv4L3Protocol resets the offset after reassembly but keeps the
+        // identification, so the datagram matches the fragments it came from
+        if (self->m_reassembling[nodeId].erase(Key(header)) > 0)
+        {
+            self->m_counters[nodeId].datagramsReassembled++;
+        }
+    }
+
+    static void DropTrace(FragmentationStats* self,
+                          uint32_t nodeId,
+                          const Ipv4Header& header,
+                          Ptr<const Packet> packet,
+                          Ipv4L3Protocol::DropReason reason,
+                          Ptr<Ipv4> ipv4,
+                          uint32_t interface)
+    {
+        if (reason == Ipv4L3Protocol::DROP_FRAGMENT_TIMEOUT)
+        {
+            self->m_counters[nodeId].reassemblyTimeouts++;
+            self->m_reassembling[nodeId].erase(Key(header));
+        }
+    }
+
+    std::map<uint32_t, NodeCounters> m_counters;               //!< Counters indexed by node id
+    std::map<uint32_t, std::set<FragmentKey>> m_reassembling; //!< Datagrams being reassembled
+};
+
+} // namespace ns3
+
+#endif /* WAN_FRAGMENTATION_STATS_H */
@@ -0,0 +1,332 @@
+#ifndef WAN_HIERARCHICAL_FIB_H
+#define WAN_HIERARCHICAL_FIB_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Two-level FIB: prefixes point to shared next-hop groups.
+ *
+ * A next-hop group is an ordered list of (next hop, interface) members, the
+ * first live one being active. Any number of prefixes reference the same
+ * group by index, so when an interface fails only the groups that use it
+ * are touched, never the prefixes (prefix-independent convergence).
+ *
+ * Prefixes are kept in one hash table per prefix length; a lookup probes
+ * only the lengths that are in use, longest first.
+ */
+class Ipv4HierarchicalFib : public Ipv4RoutingProtocol
+{
+  public:
+    /// Value of an unused group or member index.
+    static constexpr uint32_t NONE = 0xffffffff;
+
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::Ipv4HierarchicalFib")
+                                .SetParent<Ipv4RoutingProtocol>()
+                                .AddConstructor<Ipv4HierarchicalFib>();
+        return tid;
+    }
+
+    /**
+     * @brief Create an empty next-hop group.
+     * @return The group index.
+     */
+    uint32_t CreateGroup()
+    {
+        m_groups.emplace_back();
+        return m_groups.size() - 1;
+    }
+
+    /**
+     * @brief Add a member to a group; members are kept ordered by metric.
+     *
+     * @param group Group index.
+     * @param nextHop Next hop address.
+     * @param interface Output interface.
+     * @param metric Preference, lower is better.
+     */
+    void AddGroupMember(uint32_t group, Ipv4Address nextHop, uint32_t interface, uint32_t metric)
+    {
+        Group& g = m_groups.at(group);
+        Member member{nextHop, interface, metric, true};
+        auto pos = std::upper_bound(g.members.begin(),
+                                    g.members.end(),
+                                    member,
+                                    [](const Member& a, const Member& b) {
+                                        return a.metric < b.metric;
+                                    });
+        g.members.insert(pos, member);
+        if (interface >= m_interfaceGroups.size())
+        {
+            m_interfaceGroups.resize(interface + 1);
+        }
+        std::vector<uint32_t>& users = m_interfaceGroups[interface];
+        if (std::find(users.begin(), users.end(), group) == users.end())
+        {
+            users.push_back(group);
+        }
+        SelectActive(g);
+    }
+
+    /**
+     * @brief Point a prefix at a group.
+     *
+     * @param network Destination network.
+     * @param mask Network mask.
+     * @param group Group index.
+     */
+    void AddPrefix(Ipv4Address network, Ipv4Mask mask, uint32_t group)
+    {
+        uint16_t length = mask.GetPrefixLength();
+        m_prefixes[length][network.CombineMask(mask).Get()] = group;
+        m_usedLengths |= uint64_t(1) << length;
+    }
+
+    /// @return Number of prefixes installed.
+    size_t GetNPrefixes() const
+    {
+        size_t n = 0;
+        for (const auto& table : m_prefixes)
+        {
+            n += table.size();
+        }
+        return n;
+    }
+
+    /**
+     * @brief Withdraw the members using a failed device.
+     *
+     * Equivalent to the interface going down; schedule it next to
+     * DisableLink() for the same device.
+     *
+     * @param device The device that went down.
+     * @return Number of groups whose active member changed.
+     */
+    uint32_t LinkDown(Ptr<NetDevice> device)
+    {
+        int32_t interface = m_ipv4->GetInterfaceForDevice(device);
+        return interface < 0 ? 0 : SetInterfaceState(interface, false);
+    }
+
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                               const Ipv4Header& header,
+                               Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override
+    {
+        Ptr<Ipv4Route> route = Lookup(header.GetDestination());
+        if (route && oif && route->GetOutputDevice() != oif)
+        {
+            route = nullptr;
+        }
+        sockerr = route ? Socket::ERROR_NOTERROR : Socket::ERROR_NOROUTETOHOST;
+        return route;
+    }
+
+    bool RouteInput(Ptr<const Packet> p,
+                    const Ipv4Header& header,
+                    Ptr<const NetDevice> idev,
+                    const UnicastForwardCallback& ucb,
+                    const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb,
+                    const ErrorCallback& ecb) override
+    {
+        if (header.GetDestination().IsMulticast())
+        {
+            return false;
+        }
+        Ptr<Ipv4Route> route = Lookup(header.GetDestination());
+        if (!route)
+        {
+            return false;
+        }
+        ucb(route, p, header);
+        return true;
+    }
+
+    void NotifyInterfaceUp(uint32_t interface) override
+    {
+        SetInterfaceState(interface, true);
+    }
+
+    void NotifyInterfaceDown(uint32_t interface) override
+    {
+        SetInterfaceState(interface, false);
+    }
+
+    void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void SetIpv4(Ptr<Ipv4> ipv4) override
+    {
+        m_ipv4 = ipv4;
+    }
+
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+                           Time::Unit unit = Time::S) const override
+    {
+        std::ostream& os = *stream->GetStream();
+        os << "Hierarchical FIB: " << GetNPrefixes() << " prefixes, " << m_groups.size()
+           << " next-hop groups\n";
+        for (uint32_t i = 0; i < m_groups.size(); ++i)
+        {
+            const Group& g = m_groups[i];
+            os << "  group " << i << ":";
+            for (uint32_t m = 0; m < g.members.size(); ++m)
+            {
+                os << (m == g.active ? " *" : " ") << g.members[m].nextHop << "/if"
+                   << g.members[m].interface << (g.members[m].up ? "" : "(down)");
+            }
+            os << "\n";
+        }
+        // Print small tables in full; large ones only by group fan-in
+        if (GetNPrefixes() <= 64)
+        {
+            for (int length = 32; length >= 0; --length)
+            {
+                for (const auto& entry : m_prefixes[length])
+                {
+                    os << "  " << Ipv4Address(entry.first) << "/" << length << " -> group "
+                       << entry.second << "\n";
+                }
+            }
+        }
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_ipv4 = nullptr;
+        Ipv4RoutingProtocol::DoDispose();
+    }
+
+  private:
+    /// Member of a next-hop group.
+    struct Member
+    {
+        Ipv4Address nextHop; //!< Next hop address
+        uint32_t interface;  //!< Output interface
+        uint32_t metric;     //!< Preference, lower is better
+        bool up;             //!< False while the interface is down
+    };
+
+    /// Shared next-hop group.
+    struct Group
+    {
+        std::vector<Member> members; //!< Members ordered by metric
+        uint32_t active{NONE};       //!< Index of the member in use
+    };
+
+    static bool SelectActive(Group& g)
+    {
+        uint32_t previous = g.active;
+        g.active = NONE;
+        for (uint32_t m = 0; m < g.members.size(); ++m)
+        {
+            if (g.members[m].up)
+            {
+                g.active = m;
+                break;
+            }
+        }
+        return g.active != previous;
+    }
+
+    uint32_t SetInterfaceState(uint32_t interface, bool up)
+    {
+        if (interface >= m_interfaceGroups.size())
+        {
+            return 0;
+        }
+        uint32_t changed = 0;
+        for (uint32_t index : m_interfaceGroups[interface])
+        {
+            Group& g = m_groups[index];
+            for (Member& member : g.members)
+            {
+                if (member.interface == interface)
+                {
+                    member.up = up;
+                }
+            }
+            changed += SelectActive(g) ? 1 : 0;
+        }
+        return changed;
+    }
+
+    Ptr<Ipv4Route> Lookup(Ipv4Address dest) const
+    {
+        uint32_t d = dest.Get();
+        uint64_t lengths = m_usedLengths;
+        while (lengths)
+        {
+            int length = 63 - __builtin_clzll(lengths);
+            lengths &= ~(uint64_t(1) << length);
+            uint32_t mask = length ? ~uint32_t(0) << (32 - length) : 0;
+            auto it = m_prefixes[length].find(d & mask);
+            if (it == m_prefixes[length].end())
+            {
+                continue;
+            }
+            const Group& g = m_groups[it->second];
+            if (g.active == NONE)
+            {
+                return nullptr;
+            }
+            const Member& member = g.members[g.active];
+            Ptr<Ipv4Route> route = Create<Ipv4Route>();
+            route->SetDestination(dest);
+            route->SetGateway(member.nextHop);
+            route->SetOutputDevice(m_ipv4->GetNetDevice(member.interface));
+            route->SetSource(m_ipv4->GetAddress(member.interface, 0).GetLocal());
+            return route;
+        }
+        return nullptr;
+    }
+
+    Ptr<Ipv4> m_ipv4;                                          //!< IPv4 of the router
+    std::vector<Group> m_groups;                               //!< Next-hop groups
+    std::unordered_map<uint32_t, uint32_t> m_prefixes[33];     //!< Prefix -> group, by length
+    uint64_t m_usedLengths{0};                                 //!< Bit n set if /n is in use
+    std::vector<std::vector<uint32_t>> m_interfaceGroups;      //!< Groups using each interface
+};
+
+/**
+ * @brief Add an Ipv4HierarchicalFib in front of the static routing of a node.
+ *
+ * @param node Node with an installed Internet stack.
+ * @return The FIB.
+ */
+inline Ptr<Ipv4HierarchicalFib>
+InstallHierarchicalFib(Ptr<Node> node)
+{
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+    Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(ipv4->GetRoutingProtocol());
+    NS_ABORT_MSG_IF(!list, "The hierarchical FIB needs the default Ipv4ListRouting");
+    Ptr<Ipv4HierarchicalFib> fib = CreateObject<Ipv4HierarchicalFib>();
+    list->AddRoutingProtocol(fib, 5);
+    return fib;
+}
+
+} // namespace ns3
+
+#endif /* WAN_HIERARCHICAL_FIB_H */
@@ -0,0 +1,467 @@
+#ifndef WAN_HTB_H
+#define WAN_HTB_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Hierarchical token bucket queue disc, after Linux HTB.
+ *
+ * Classes form a tree; each has an assured rate, a ceiling and a priority,
+ * and leaves hold a FIFO. A class is in one of three modes: it may send on
+ * its own tokens, it may only borrow from an ancestor (own tokens spent,
+ * ceiling tokens left), or it may not send. Classes that may send are kept
+ * in one ordered row per tree level, borrowers in their parent's feed, and
+ * every class whose mode will improve with time in a wait set keyed by that
+ * time. Tokens are refilled lazily from the elapsed time whenever a class
+ * is looked at, so there is no periodic refill event: the only timer is a
+ * watchdog that restarts the queue disc when the earliest waiting class can
+ * send again. Dequeue is O(depth * log n) in the number of classes.
+ *
+ * Within a row or feed, classes are served by priority and then round
+ * robin, one packet per turn.
+ */
+class HtbQueueDisc : public QueueDisc
+{
+  public:
+    /// Value of an unused class index.
+    static constexpr uint32_t NONE = 0xffffffff;
+
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::HtbQueueDisc")
+                .SetParent<QueueDisc>()
+                .AddConstructor<HtbQueueDisc>()
+                .AddAttribute("LeafQueueSize",
+                              "Packets held by each leaf class.",
+                              UintegerValue(100),
+                              MakeUintegerAccessor(&HtbQueueDisc::m_leafQueueSize),
+                              MakeUintegerChecker<uint32_t>(1))
+                .AddAttribute("Burst",
+                              "Time worth of tokens a class can accumulate.",
+                              TimeValue(MilliSeconds(20)),
+                              MakeTimeAccessor(&HtbQueueDisc::m_burst),
+                              MakeTimeChecker());
+        return tid;
+    }
+
+    HtbQueueDisc()
+        : QueueDisc(QueueDiscSizePolicy::MULTIPLE_QUEUES)
+    {
+    }
+
+    /**
+     * @brief Add a class; the first one added is the root.
+     *
+     * Classes without children when the queue disc starts are leaves.
+     *
+     * @param parent Parent class, NONE for the root.
+     * @param rate Assured rate; 0 makes a pure borrower.
+     * @param ceil Rate the class may reach by borrowing, above 0.
+     * @param prio Priority among siblings, lower first.
+     * @return The class index.
+     */
+    uint32_t AddClass(uint32_t parent, DataRate rate, DataRate ceil, uint8_t prio = 0)
+    {
+        NS_ABORT_MSG_IF((parent == NONE) != m_classes.empty(), "HTB needs exactly one root");
+        NS_ABORT_MSG_IF(std::max(rate, ceil).GetBitRate() == 0, "An HTB class needs a ceiling");
+        Class c;
+        c.parent = parent;
+        c.rate = rate.GetBitRate() / 8.0;
+        c.ceil = std::max(ceil.GetBitRate(), rate.GetBitRate()) / 8.0;
+        c.prio = prio;
+        m_classes.push_back(c);
+        uint32_t id = m_classes.size() - 1;
+        if (parent != NONE)
+        {
+            m_classes.at(parent).children.push_back(id);
+        }
+        return id;
+    }
+
+    /**
+     * @brief Set the function mapping a packet to a leaf class.
+     *
+     * @param classifier Returns a leaf index; anything else selects the default class.
+     */
+    void SetClassifier(Callback<uint32_t, Ptr<const QueueDiscItem>> classifier)
+    {
+        m_classifier = classifier;
+    }
+
+    /// @param leaf Leaf receiving unclassified packets.
+    void SetDefaultClass(uint32_t leaf)
+    {
+        m_defaultClass = leaf;
+    }
+
+    /// @return Number of classes.
+    uint32_t GetNClasses() const
+    {
+        return m_classes.size();
+    }
+
+    /**
+     * @brief Write per-class bytes sent, lends and borrows.
+     *
+     * Only the first @p maxClasses classes are listed.
+     *
+     * @param os Output stream.
+     * @param maxClasses Listing limit.
+     */
+    void Print(std::ostream& os, uint32_t maxClasses = 16) const
+    {
+        os << m_classes.size() << " classes, " << m_watchdogs << " watchdog events\n";
+        for (uint32_t i = 0; i < m_classes.size() && i < maxClasses; ++i)
+        {
+            const Class& c = m_classes[i];
+            os << "  class " << i << (c.children.empty() ? " leaf" : "") << " rate "
+               << c.rate * 8 / 1e6 << " ceil " << c.ceil * 8 / 1e6 << " Mbps: sent "
+               << c.sentBytes << " bytes, lends " << c.lends << ", borrows " << c.borrows
+               << "\n";
+        }
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_watchdog.Cancel();
+        m_classifier = MakeNullCallback<uint32_t, Ptr<const QueueDiscItem>>();
+        QueueDisc::DoDispose();
+    }
+
+  private:
+    /// What a class may do right now.
+    enum Mode
+    {
+        CAN_SEND,   //!< Own tokens left
+        MAY_BORROW, //!< Only ceiling tokens left
+        CANT_SEND   //!< No ceiling tokens left
+    };
+
+    /// Where a class is linked.
+    enum Where
+    {
+        NOWHERE, //!< Inactive or CANT_SEND
+        ROW,     //!< In the row of its level
+        FEED     //!< In its parent's feed
+    };
+
+    /// Ordering within a row or feed: priority, then round robin.
+    using Key = std::tuple<uint8_t, uint64_t, uint32_t>;
+
+    /// A class of the tree.
+    struct Class
+    {
+        uint32_t parent{NONE};          //!< Parent class
+        std::vector<uint32_t> children; //!< Child classes
+        uint32_t level{0};              //!< Height, 0 for leaves
+        uint8_t prio{0};                //!< Priority among siblings
+        double rate{0};                 //!< Assured rate in bytes/s
+        double ceil{0};                 //!< Ceiling in bytes/s
+        double burst{0};                //!< Token bucket depth in bytes
+        double cburst{0};               //!< Ceiling bucket depth in bytes
+        double tokens{0};               //!< Own tokens in bytes
+        double ctokens{0};              //!< Ceiling tokens in bytes
+        Time checkpoint;                //!< Time of the last refill
+        Mode mode{CAN_SEND};            //!< Mode at the checkpoint
+        uint64_t seq{0};                //!< Round-robin stamp
+        Where where{NOWHERE};           //!< Current link
+        Key key;                        //!< Key it is linked under
+        bool waiting{false};            //!< In the wait set
+        Time wakeAt;                    //!< Key in the wait set
+        std::set<Key> feed;             //!< Borrowing children with backlog
+        uint32_t queue{NONE};           //!< Internal queue of a leaf
+        uint64_t sentBytes{0};          //!< Bytes sent through the class
+        uint64_t lends{0};              //!< Packets sent on this class's own tokens
+        uint64_t borrows{0};            //!< Packets sent on an ancestor's tokens
+    };
+
+    /// @return The log component, registered on first use (this header has no .cc file).
+    static LogComponent& GetLog()
+    {
+        static LogComponent log("HtbQueueDisc", __FILE__);
+        return log;
+    }
+
+    bool CheckConfig() override
+    {
+        if (GetNQueueDiscClasses() > 0 || GetNPacketFilters() > 0 || m_classes.empty())
+        {
+            [[maybe_unused]] LogComponent& g_log = GetLog();
+            NS_LOG_ERROR("HtbQueueDisc needs a class tree and no queue disc classes or filters");
+            return false;
+        }
+        // Heights, bottom-up: children always have higher indices than their parent
+        for (uint32_t i = m_classes.size(); i-- > 0;)
+        {
+            Class& c = m_classes[i];
+            if (c.parent != NONE)
+            {
+                Class& p = m_classes[c.parent];
+                p.level = std::max(p.level, c.level + 1);
+            }
+        }
+        m_rows.assign(m_classes[0].level + 1, {});
+        for (Class& c : m_classes)
+        {
+            c.burst = std::max(3000.0, c.rate * m_burst.GetSeconds());
+            c.cburst = std::max(3000.0, c.ceil * m_burst.GetSeconds());
+            c.tokens = c.burst;
+            c.ctokens = c.cburst;
+            if (c.children.empty())
+            {
+                c.queue = GetNInternalQueues();
+                AddInternalQueue(CreateObjectWithAttributes<DropTailQueue<QueueDiscItem>>(
+                    "MaxSize",
+                    QueueSizeValue(QueueSize(QueueSizeUnit::PACKETS, m_leafQueueSize))));
+            }
+        }
+        if (m_defaultClass == NONE || !m_classes.at(m_defaultClass).children.empty())
+        {
+            // Last leaf added
+            for (uint32_t i = m_classes.size(); i-- > 0;)
+            {
+                if (m_classes[i].children.empty())
+                {
+                    m_defaultClass = i;
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    void InitializeParams() override
+    {
+    }
+
+    bool DoEnqueue(Ptr<QueueDiscItem> item) override
+    {
+        uint32_t id = m_classifier.IsNull() ? NONE : m_classifier(item);
+        if (id >= m_classes.size() || !m_classes[id].children.empty())
+        {
+            id = m_defaultClass;
+        }
+        bool wasActive = IsActive(id);
+        if (!GetInternalQueue(m_classes[id].queue)->Enqueue(item))
+        {
+            return false;
+        }
+        if (!wasActive)
+        {
+            Update(id);
+        }
+        return true;
+    }
+
+    Ptr<QueueDiscItem> DoDequeue() override
+    {
+        Time now = Simulator::Now();
+        while (!m_wait.empty() && m_wait.begin()->first <= now)
+        {
+            uint32_t id = m_wait.begin()->second;
+            m_wait.erase(m_wait.begin());
+            m_classes[id].waiting = false;
+            Update(id);
+        }
+        for (uint32_t level = 0; level < m_rows.size(); ++level)
+        {
+            if (m_rows[level].empty())
+            {
+                continue;
+            }
+            uint32_t leaf = std::get<2>(*m_rows[level].begin());
+            while (!m_classes[leaf].children.empty())
+            {
+                leaf = std::get<2>(*m_classes[leaf].feed.begin());
+            }
+            Ptr<QueueDiscItem> item = GetInternalQueue(m_classes[leaf].queue)->Dequeue();
+            Charge(leaf, level, item->GetSize());
+            return item;
+        }
+        if (!m_wait.empty())
+        {
+            ArmWatchdog(m_wait.begin()->first);
+        }
+        return nullptr;
+    }
+
+    bool IsActive(uint32_t id) const
+    {
+        const Class& c = m_classes[id];
+        return c.children.empty() ? GetInternalQueue(c.queue)->GetNPackets() > 0
+                                  : !c.feed.empty();
+    }
+
+    void Refill(Class& c, Time now)
+    {
+        double elapsed = (now - c.checkpoint).GetSeconds();
+        c.tokens = std::min(c.burst, c.tokens + c.rate * elapsed);
+        c.ctokens = std::min(c.cburst, c.ctokens + c.ceil * elapsed);
+        c.checkpoint = now;
+    }
+
+    /// Refill, recompute the mode and relink a class.
+    void Update(uint32_t id)
+    {
+        Class& c = m_classes[id];
+        Time now = Simulator::Now();
+        Refill(c, now);
+        // Tolerate rounding so that a class woken on time is not put back to sleep
+        const double epsilon = 1e-6;
+        c.mode = c.ctokens < -epsilon ? CANT_SEND : c.tokens < -epsilon ? MAY_BORROW : CAN_SEND;
+        Unlink(id);
+        if (c.waiting)
+        {
+            m_wait.erase({c.wakeAt, id});
+            c.waiting = false;
+        }
+        if (!IsActive(id))
+        {
+            return;
+        }
+        Link(id);
+        // A class without an assured rate borrows for good; only the ceiling can stop it
+        if (c.mode == CANT_SEND || (c.mode == MAY_BORROW && c.rate > 0))
+        {
+            double deficit = c.mode == CANT_SEND ? -c.ctokens / c.ceil : -c.tokens / c.rate;
+            c.wakeAt = now + NanoSeconds(int64_t(std::ceil(deficit * 1e9)));
+            c.waiting = true;
+            m_wait.insert({c.wakeAt, id});
+        }
+    }
+
+    void Link(uint32_t id)
+    {
+        Class& c = m_classes[id];
+        c.key = Key{c.prio, c.seq, id};
+        if (c.mode == CAN_SEND)
+        {
+            m_rows[c.level].insert(c.key);
+            c.where = ROW;
+        }
+        else if (c.mode == MAY_BORROW && c.parent != NONE)
+        {
+            Class& p = m_classes[c.parent];
+            bool parentWasActive = !p.feed.empty();
+            p.feed.insert(c.key);
+            c.where = FEED;
+            if (!parentWasActive)
+            {
+                Update(c.parent);
+            }
+        }
+    }
+
+    void Unlink(uint32_t id)
+    {
+        Class& c = m_classes[id];
+        if (c.where == ROW)
+        {
+            m_rows[c.level].erase(c.key);
+        }
+        else if (c.where == FEED)
+        {
+            Class& p = m_classes[c.parent];
+            p.feed.erase(c.key);
+            if (p.feed.empty())
+            {
+                Update(c.parent);
+            }
+        }
+        c.where = NOWHERE;
+    }
+
+    /// Charge a packet sent by @p leaf on the tokens of the class at @p level.
+    void Charge(uint32_t leaf, uint32_t level, uint32_t bytes)
+    {
+        Time now = Simulator::Now();
+        for (uint32_t id = leaf; id != NONE; id = m_classes[id].parent)
+        {
+            Class& c = m_classes[id];
+            Refill(c, now);
+            if (c.level >= level)
+            {
+                c.tokens -= bytes;
+                c.lends += c.level == level ? 1 : 0;
+            }
+            else
+            {
+                c.borrows++;
+            }
+            c.ctokens -= bytes;
+            c.sentBytes += bytes;
+            c.seq = ++m_seq;
+        }
+        for (uint32_t id = leaf; id != NONE; id = m_classes[id].parent)
+        {
+            Update(id);
+        }
+    }
+
+    void ArmWatchdog(Time at)
+    {
+        if (m_watchdog.IsPending() && m_watchdog.GetTs() <= uint64_t(at.GetTimeStep()))
+        {
+            return;
+        }
+        m_watchdog.Cancel();
+        m_watchdog = Simulator::Schedule(at - Simulator::Now(), &HtbQueueDisc::Run, this);
+        m_watchdogs++;
+    }
+
+    std::vector<Class> m_classes;                              //!< Class tree, root first
+    std::vector<std::set<Key>> m_rows;                         //!< Sending classes per level
+    std::set<std::pair<Time, uint32_t>> m_wait;                //!< Classes by wake time
+    Callback<uint32_t, Ptr<const QueueDiscItem>> m_classifier; //!< Packet to leaf
+    uint32_t m_defaultClass{NONE};                             //!< Leaf for the rest
+    uint32_t m_leafQueueSize{100};                             //!< Leaf FIFO limit
+    Time m_burst;                                              //!< Bucket depth in time
+    uint64_t m_seq{0};                                         //!< Round-robin clock
+    EventId m_watchdog;                                        //!< Restart when a class wakes
+    uint64_t m_watchdogs{0};                                   //!< Watchdog events scheduled
+};
+
+/**
+ * @brief Replace the root queue disc of a device by an HtbQueueDisc.
+ *
+ * Build the class tree on the returned queue disc before the simulation starts.
+ *
+ * @param device Device whose egress to shape.
+ * @return The queue disc.
+ */
+inline Ptr<HtbQueueDisc>
+InstallHtb(Ptr<NetDevice> device)
+{
+    Ptr<TrafficControlLayer> tc = device->GetNode()->GetObject<TrafficControlLayer>();
+    NS_ABORT_MSG_IF(!tc, "HTB needs the traffic control layer of the Internet stack");
+    if (tc->GetRootQueueDiscOnDevice(device))
+    {
+        tc->DeleteRootQueueDiscOnDevice(device);
+    }
+    Ptr<HtbQueueDisc> htb = CreateObject<HtbQueueDisc>();
+    tc->SetRootQueueDiscOnDevice(device, htb);
+    return htb;
+}
+
+} // namespace ns3
+
+#endif /* WAN_HTB_H */
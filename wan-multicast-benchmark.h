@@ -0,0 +1,118 @@
+#ifndef WAN_MULTICAST_BENCHMARK_H
+#define WAN_MULTICAST_BENCHMARK_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/ipv4-static-routing-helper.h"
+
+#include <chrono>
+#include <ostream>
+
+namespace ns3
+{
+
+/**
+ * @brief Measure the cost of multicast replication at a single router.
+ *
+ * Builds source -> hub -> N receivers over point-to-point links, installs
+ * one static multicast route on the hub with all N receiver links as
+ * outputs, and sends a fixed number of datagrams to the group. The hub
+ * forwards a Packet::Copy() per output: the copies share one reference
+ * counted buffer and only the prepended headers are written per replica.
+ *
+ * The function runs and destroys its own simulation, so it must not be
+ * called while another scenario is set up.
+ *
+ * @param receivers Number of receiver nodes behind the hub.
+ * @param packets Datagrams sent by the source.
+ * @param packetSize Payload size of each datagram.
+ * @param os Stream receiving the report.
+ */
+inline void
+RunMulticastReplicationBenchmark(uint32_t receivers,
+                                 uint32_t packets,
+                                 uint32_t packetSize,
+                                 std::ostream& os)
+{
+    const Ipv4Address group("225.1.2.4");
+    const uint16_t port = 9000;
+
+    NodeContainer source;
+    source.Create(1);
+    NodeContainer hub;
+    hub.Create(1);
+    NodeContainer sinks;
+    sinks.Create(receivers);
+
+    InternetStackHelper stack;
+    stack.Install(source);
+    stack.Install(hub);
+    stack.Install(sinks);
+
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("5Mbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("2ms"));
+
+    Ipv4AddressHelper address;
+    address.SetBase("10.128.0.0", "255.255.255.252");
+    NetDeviceContainer uplink = p2p.Install(source.Get(0), hub.Get(0));
+    address.Assign(uplink);
+    address.NewNetwork();
+
+    // Hub interface 1 is the uplink; receiver links are interfaces 2..N+1
+    std::vector<uint32_t> outputs;
+    outputs.reserve(receivers);
+    for (uint32_t i = 0; i < receivers; ++i)
+    {
+        NetDeviceContainer link = p2p.Install(hub.Get(0), sinks.Get(i));
+        address.Assign(link);
+        address.NewNetwork();
+        outputs.push_back(i + 2);
+    }
+
+    Ipv4StaticRoutingHelper staticRoutingHelper;
+    staticRoutingHelper.SetDefaultMulticastRoute(source.Get(0), uplink.Get(0));
+    Ptr<Ipv4StaticRouting> hubRouting =
+        staticRoutingHelper.GetStaticRouting(hub.Get(0)->GetObject<Ipv4>());
+    hubRouting->AddMulticastRoute(Ipv4Address::GetAny(), group, 1, outputs);
+    hub.Get(0)->GetObject<Ipv4>()->SetAttribute("IpForward", BooleanValue(true));
+
+    PacketSinkHelper sinkHelper("ns3::UdpSocketFactory",
+                                InetSocketAddress(Ipv4Address::GetAny(), port));
+    ApplicationContainer sinkApps = sinkHelper.Install(sinks);
+    sinkApps.Start(Seconds(0.0));
+
+    UdpClientHelper client(group, port);
+    client.SetAttribute("MaxPackets", UintegerValue(packets));
+    client.SetAttribute("Interval", TimeValue(MilliSeconds(10)));
+    client.SetAttribute("PacketSize", UintegerValue(packetSize));
+    ApplicationContainer clientApps = client.Install(source.Get(0));
+    clientApps.Start(Seconds(1.0));
+
+    Simulator::Stop(Seconds(1.0) + MilliSeconds(10) * packets + Seconds(1.0));
+    auto begin = std::chrono::steady_clock::now();
+    Simulator::Run();
+    auto end = std::chrono::steady_clock::now();
+
+    uint64_t delivered = 0;
+    for (uint32_t i = 0; i < sinkApps.GetN(); ++i)
+    {
+        delivered += DynamicCast<PacketSink>(sinkApps.Get(i))->GetTotalRx() / packetSize;
+    }
+    double wallUs = std::chrono::duration<double, std::micro>(end - begin).count();
+
+    os << "Multicast replication: " << receivers << " receivers, " << packets
+       << " datagrams of " << packetSize << " bytes\n";
+    os << "Delivered copies: " << delivered << " of " << uint64_t(receivers) * packets << "\n";
+    os << "Wall time: " << wallUs / 1000.0 << " ms, "
+       << (delivered ? wallUs * 1000.0 / delivered : 0.0) << " ns per delivered copy\n";
+
+    Simulator::Destroy();
+}
+
+} // namespace ns3
+
+#endif /* WAN_MULTICAST_BENCHMARK_H */
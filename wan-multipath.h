@@ -0,0 +1,614 @@
+#ifndef WAN_MULTIPATH_H
+#define WAN_MULTIPATH_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Byte tag carrying the data sequence number of a multipath chunk.
+ *
+ * Byte tags stay on their bytes through TCP segmentation and reassembly,
+ * so the receiver can tell a reinjected byte from a new one whichever
+ * subflow carried it.
+ */
+class DataSequenceTag : public Tag
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::DataSequenceTag").SetParent<Tag>().AddConstructor<DataSequenceTag>();
+        return tid;
+    }
+
+    TypeId GetInstanceTypeId() const override
+    {
+        return GetTypeId();
+    }
+
+    uint32_t GetSerializedSize() const override
+    {
+        return 8;
+    }
+
+    void Serialize(TagBuffer i) const override
+    {
+        i.WriteU64(m_sequence);
+    }
+
+    void Deserialize(TagBuffer i) override
+    {
+        m_sequence = i.ReadU64();
+    }
+
+    void Print(std::ostream& os) const override
+    {
+        os << "dsn=" << m_sequence;
+    }
+
+    /// @param sequence Offset of the chunk's first byte in the transfer.
+    void SetSequence(uint64_t sequence)
+    {
+        m_sequence = sequence;
+    }
+
+    /// @return Offset of the chunk's first byte in the transfer.
+    uint64_t GetSequence() const
+    {
+        return m_sequence;
+    }
+
+  private:
+    uint64_t m_sequence{0}; //!< Data sequence number
+};
+
+/**
+ * @brief Shared state of the subflows of one multipath connection.
+ *
+ * Each subflow registers its TcpSocketState the first time it grows its
+ * window, so the coupled controller can see the window and RTT of all
+ * live subflows.
+ */
+class CoupledGroup : public SimpleRefCount<CoupledGroup>
+{
+  public:
+    /// @param tcb Subflow state to include (ignored if already present).
+    void Register(Ptr<TcpSocketState> tcb)
+    {
+        if (std::find(m_subflows.begin(), m_subflows.end(), tcb) == m_subflows.end())
+        {
+            m_subflows.push_back(tcb);
+        }
+    }
+
+    /// @param tcb Subflow state to drop from the coupling.
+    void Deregister(Ptr<TcpSocketState> tcb)
+    {
+        m_subflows.erase(std::remove(m_subflows.begin(), m_subflows.end(), tcb),
+                         m_subflows.end());
+    }
+
+    /// @return The live subflows.
+    const std::vector<Ptr<TcpSocketState>>& GetSubflows() const
+    {
+        return m_subflows;
+    }
+
+  private:
+    std::vector<Ptr<TcpSocketState>> m_subflows; //!< Live subflows
+};
+
+/**
+ * @brief Linked Increases Algorithm (RFC 6356) for multipath subflows.
+ *
+ * Slow start and loss response are NewReno's. In congestion avoidance the
+ * window of subflow i grows by
+ * min(alpha * acked * MSS / cwnd_total, acked * MSS / cwnd_i), with
+ * alpha = cwnd_total * max(cwnd_k / rtt_k^2) / (sum(cwnd_k / rtt_k))^2,
+ * so the connection takes no more than one TCP flow would on the best path.
+ */
+class TcpCoupledLia : public TcpNewReno
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::TcpCoupledLia")
+                                .SetParent<TcpNewReno>()
+                                .AddConstructor<TcpCoupledLia>();
+        return tid;
+    }
+
+    TcpCoupledLia() = default;
+
+    /**
+     * @brief Copy constructor used by Fork().
+     * @param other The object to copy.
+     */
+    TcpCoupledLia(const TcpCoupledLia& other)
+        : TcpNewReno(other),
+          m_group(other.m_group)
+    {
+    }
+
+    /// @param group Group shared by all subflows of the connection.
+    void SetGroup(Ptr<CoupledGroup> group)
+    {
+        m_group = group;
+    }
+
+    /// Leave the group, e.g. when the subflow is abandoned.
+    void Detach()
+    {
+        if (m_group && m_tcb)
+        {
+            m_group->Deregister(m_tcb);
+        }
+        m_group = nullptr;
+        m_tcb = nullptr;
+    }
+
+    std::string GetName() const override
+    {
+        return "TcpCoupledLia";
+    }
+
+    Ptr<TcpCongestionOps> Fork() override
+    {
+        return CopyObject<TcpCoupledLia>(this);
+    }
+
+  protected:
+    void CongestionAvoidance(Ptr<TcpSocketState> tcb, uint32_t segmentsAcked) override
+    {
+        if (!m_group)
+        {
+            TcpNewReno::CongestionAvoidance(tcb, segmentsAcked);
+            return;
+        }
+        m_tcb = tcb;
+        m_group->Register(tcb);
+        double total = 0;
+        double best = 0;
+        double sum = 0;
+        for (Ptr<TcpSocketState> s : m_group->GetSubflows())
+        {
+            double cwnd = s->m_cWnd.Get();
+            double rtt = std::max(s->m_lastRtt.Get().GetSeconds(), 1e-6);
+            total += cwnd;
+            best = std::max(best, cwnd / (rtt * rtt));
+            sum += cwnd / rtt;
+        }
+        double alpha = sum > 0 ? total * best / (sum * sum) : 1.0;
+        double acked = double(segmentsAcked) * tcb->m_segmentSize;
+        double coupled = alpha * acked * tcb->m_segmentSize / total;
+        double uncoupled = acked * tcb->m_segmentSize / tcb->m_cWnd.Get();
+        m_pending += std::min(coupled, uncoupled);
+        if (m_pending >= 1.0)
+        {
+            uint32_t grow = uint32_t(m_pending);
+            tcb->m_cWnd += grow;
+            m_pending -= grow;
+        }
+    }
+
+  private:
+    Ptr<CoupledGroup> m_group; //!< Subflows coupled with this one
+    Ptr<TcpSocketState> m_tcb; //!< State of this subflow once seen
+    double m_pending{0};       //!< Fractional window growth not applied yet
+};
+
+/**
+ * @brief Bulk sender spreading one transfer over several pinned TCP subflows.
+ *
+ * Each subflow is bound to an output device, so its path is fixed whatever
+ * the routing table prefers. Data is pulled by whichever subflow has send
+ * buffer room. A subflow whose ACKs stop advancing for StallTimeout while it
+ * has data outstanding is abandoned and its unacknowledged bytes are
+ * reinjected on the remaining subflows. Every chunk carries a
+ * DataSequenceTag, so a receiver can discard bytes it already got.
+ */
+class MultipathBulkSender : public Application
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::MultipathBulkSender")
+                .SetParent<Application>()
+                .AddConstructor<MultipathBulkSender>()
+                .AddAttribute("MaxBytes",
+                              "Bytes to transfer.",
+                              UintegerValue(10000000),
+                              MakeUintegerAccessor(&MultipathBulkSender::m_maxBytes),
+                              MakeUintegerChecker<uint64_t>())
+                .AddAttribute("StallTimeout",
+                              "ACK silence after which a subflow is abandoned.",
+                              TimeValue(MilliSeconds(500)),
+                              MakeTimeAccessor(&MultipathBulkSender::m_stallTimeout),
+                              MakeTimeChecker());
+        return tid;
+    }
+
+    /**
+     * @brief Add a subflow pinned to a device.
+     *
+     * @param device Output device of the subflow.
+     * @param remote Address and port of the receiver on that path.
+     */
+    void AddSubflow(Ptr<NetDevice> device, InetSocketAddress remote)
+    {
+        Subflow subflow;
+        subflow.device = device;
+        subflow.remote = remote;
+        m_subflows.push_back(subflow);
+    }
+
+    /**
+     * @brief Write per-subflow bytes and reinjections.
+     *
+     * @param os Output stream.
+     */
+    void Print(std::ostream& os) const
+    {
+        for (uint32_t i = 0; i < m_subflows.size(); ++i)
+        {
+            const Subflow& s = m_subflows[i];
+            os << "Subflow " << i << " via " << s.remote.GetIpv4() << ": written " << s.written
+               << ", acked " << s.acked << (s.alive ? "" : " (abandoned)") << "\n";
+        }
+        os << "Reinjected bytes: " << m_reinjected << "\n";
+    }
+
+  private:
+    /// Transfer bytes [sequence, sequence + length), written to a subflow at offset.
+    struct Mapping
+    {
+        uint64_t offset;   //!< Subflow byte offset (unused in m_reinject)
+        uint64_t sequence; //!< Data sequence number of the chunk
+        uint64_t length;   //!< Chunk size
+    };
+
+    /// One TCP subflow.
+    struct Subflow
+    {
+        Ptr<NetDevice> device;                              //!< Pinned output device
+        InetSocketAddress remote{Ipv4Address::GetAny(), 0}; //!< Receiver on this path
+        Ptr<Socket> socket;                                 //!< TCP socket
+        Ptr<TcpCoupledLia> cc;                              //!< Congestion controller
+        uint64_t written{0};                                //!< Bytes handed to the socket
+        uint64_t acked{0};                                  //!< Bytes acknowledged
+        std::deque<Mapping> unacked;                        //!< Chunks not fully acknowledged
+        Time lastProgress;                                  //!< Last time acked advanced
+        bool alive{true};                                   //!< False once abandoned
+    };
+
+    void StartApplication() override
+    {
+        m_remaining = m_maxBytes;
+        m_nextSequence = 0;
+        for (uint32_t i = 0; i < m_subflows.size(); ++i)
+        {
+            Subflow& s = m_subflows[i];
+            s.socket = Socket::CreateSocket(GetNode(), TcpSocketFactory::GetTypeId());
+            s.cc = CreateObject<TcpCoupledLia>();
+            s.cc->SetGroup(m_group);
+            DynamicCast<TcpSocketBase>(s.socket)->SetCongestionControlAlgorithm(s.cc);
+            s.socket->Bind();
+            s.socket->BindToNetDevice(s.device);
+            s.socket->TraceConnectWithoutContext(
+                "HighestRxAck",
+                MakeBoundCallback(&MultipathBulkSender::AckTrace, this, i));
+            s.socket->SetConnectCallback(MakeCallback(&MultipathBulkSender::Connected, this),
+                                         MakeNullCallback<void, Ptr<Socket>>());
+            s.socket->SetSendCallback(MakeCallback(&MultipathBulkSender::SendSpace, this));
+            s.socket->Connect(s.remote);
+            s.lastProgress = Simulator::Now();
+        }
+        m_checkEvent = Simulator::Schedule(m_stallTimeout / 5, &MultipathBulkSender::Check, this);
+    }
+
+    void StopApplication() override
+    {
+        m_checkEvent.Cancel();
+        for (Subflow& s : m_subflows)
+        {
+            if (s.socket)
+            {
+                s.socket->Close();
+            }
+        }
+    }
+
+    void Connected(Ptr<Socket> socket)
+    {
+        Fill();
+    }
+
+    void SendSpace(Ptr<Socket> socket, uint32_t available)
+    {
+        Fill();
+    }
+
+    void Fill()
+    {
+        for (Subflow& s : m_subflows)
+        {
+            while (s.alive && m_remaining > 0 && s.socket->GetTxAvailable() > 0)
+            {
+                if (s.written == s.acked)
+                {
+                    // An idle subflow starts its stall clock with the new data
+                    s.lastProgress = Simulator::Now();
+                }
+                // Reinjected ranges go before new data
+                bool reinject = !m_reinject.empty();
+                uint64_t sequence = reinject ? m_reinject.front().sequence : m_nextSequence;
+                uint64_t available =
+                    reinject ? m_reinject.front().length : m_maxBytes - m_nextSequence;
+                uint64_t chunk =
+                    std::min<uint64_t>({s.socket->GetTxAvailable(), available, 1448});
+                Ptr<Packet> packet = Create<Packet>(chunk);
+                DataSequenceTag tag;
+                tag.SetSequence(sequence);
+                packet->AddByteTag(tag);
+                int sent = s.socket->Send(packet);
+                if (sent <= 0)
+                {
+                    break;
+                }
+                s.unacked.push_back(Mapping{s.written, sequence, uint64_t(sent)});
+                if (reinject)
+                {
+                    m_reinject.front().sequence += sent;
+                    if ((m_reinject.front().length -= sent) == 0)
+                    {
+                        m_reinject.pop_front();
+                    }
+                }
+                else
+                {
+                    m_nextSequence += sent;
+                }
+                s.written += sent;
+                m_remaining -= sent;
+            }
+        }
+    }
+
+    static void AckTrace(MultipathBulkSender* self,
+                         uint32_t index,
+                         SequenceNumber32 oldValue,
+                         SequenceNumber32 newValue)
+    {
+        Subflow& s = self->m_subflows[index];
+        // The SYN takes sequence number 0
+        uint64_t acked = newValue.GetValue() > 0 ? newValue.GetValue() - 1 : 0;
+        if (acked > s.acked)
+        {
+            s.acked = std::min(acked, s.written);
+            s.lastProgress = Simulator::Now();
+            while (!s.unacked.empty() &&
+                   s.unacked.front().offset + s.unacked.front().length <= s.acked)
+            {
+                s.unacked.pop_front();
+            }
+        }
+    }
+
+    void Check()
+    {
+        bool busy = m_remaining > 0;
+        for (Subflow& s : m_subflows)
+        {
+            busy = busy || (s.alive && s.written > s.acked);
+            bool outstanding = s.written > s.acked;
+            if (s.alive && outstanding && Simulator::Now() - s.lastProgress > m_stallTimeout)
+            {
+                s.alive = false;
+                uint64_t lost = s.written - s.acked;
+                m_remaining += lost;
+                m_reinjected += lost;
+                for (const Mapping& m : s.unacked)
+                {
+                    uint64_t skip = s.acked > m.offset ? s.acked - m.offset : 0;
+                    m_reinject.push_back(Mapping{0, m.sequence + skip, m.length - skip});
+                }
+                s.unacked.clear();
+                s.socket->SetSendCallback(MakeNullCallback<void, Ptr<Socket>, uint32_t>());
+                s.socket->Close();
+                s.cc->Detach();
+            }
+        }
+        Fill();
+        if (busy)
+        {
+            m_checkEvent =
+                Simulator::Schedule(m_stallTimeout / 5, &MultipathBulkSender::Check, this);
+        }
+    }
+
+    std::vector<Subflow> m_subflows;                   //!< Subflows
+    Ptr<CoupledGroup> m_group{Create<CoupledGroup>()}; //!< Coupled congestion state
+    uint64_t m_maxBytes{0};                            //!< Transfer size
+    uint64_t m_remaining{0};                           //!< Bytes not yet written
+    uint64_t m_nextSequence{0};                        //!< First transfer byte never written
+    std::deque<Mapping> m_reinject;                    //!< Ranges of abandoned subflows
+    uint64_t m_reinjected{0};                          //!< Bytes sent again after a stall
+    Time m_stallTimeout;                               //!< Abandon threshold
+    EventId m_checkEvent;                              //!< Next stall check
+};
+
+/**
+ * @brief Goodput and longest delivery gap seen by a receiver after a failure.
+ *
+ * Bytes carrying a DataSequenceTag count once: a byte reinjected on a
+ * second subflow after its first copy arrived is a duplicate, not goodput.
+ * Each subflow delivers in order, so the offset of a byte in its chunk is
+ * the count of the chunk's bytes already delivered by the same sender
+ * address. Untagged streams count every byte.
+ */
+class GoodputMonitor
+{
+  public:
+    /**
+     * @param failure Time after which delivery gaps count as failover stalls.
+     */
+    explicit GoodputMonitor(Time failure)
+        : m_failure(failure)
+    {
+    }
+
+    /**
+     * @brief Watch a PacketSink.
+     * @param sink The receiving application.
+     */
+    void Install(Ptr<PacketSink> sink)
+    {
+        sink->TraceConnectWithoutContext("Rx", MakeCallback(&GoodputMonitor::Rx, this));
+    }
+
+    /**
+     * @brief Write goodput and the longest stall since the failure.
+     *
+     * A transfer that has not delivered @p expected bytes by @p end counts
+     * as stalled until then.
+     *
+     * @param os Output stream.
+     * @param end End of the observation window.
+     * @param expected Size of the transfer.
+     */
+    void Print(std::ostream& os, Time end, uint64_t expected) const
+    {
+        double active = (m_last - m_first).GetSeconds();
+        os << "Received " << m_bytes << " unique bytes (" << m_duplicates
+           << " duplicate), goodput " << (active > 0 ? m_bytes * 8 / active / 1e6 : 0.0)
+           << " Mbps\n";
+        Time stall = m_maxStall;
+        if (m_bytes < expected && end > m_failure)
+        {
+            stall = std::max(stall, end - std::max(m_last, m_failure));
+        }
+        os << "Longest delivery stall after the failure: " << stall.As(Time::MS) << "\n";
+    }
+
+  private:
+    /// Chunk being delivered by one subflow.
+    struct Chunk
+    {
+        uint64_t sequence{0};  //!< Data sequence number of the chunk
+        uint64_t delivered{0}; //!< Bytes of it delivered so far
+        bool started{false};   //!< False until the first tagged byte
+    };
+
+    /**
+     * @brief Record transfer bytes [begin, end) as received.
+     * @return Number of them not received before.
+     */
+    uint64_t Cover(uint64_t begin, uint64_t end)
+    {
+        uint64_t fresh = end - begin;
+        uint64_t low = begin;
+        uint64_t high = end;
+        auto it = m_received.upper_bound(begin);
+        if (it != m_received.begin() && std::prev(it)->second >= begin)
+        {
+            --it;
+        }
+        // Merge every range overlapping or touching [begin, end)
+        while (it != m_received.end() && it->first <= end)
+        {
+            if (it->second > begin && it->first < end)
+            {
+                fresh -= std::min(end, it->second) - std::max(begin, it->first);
+            }
+            low = std::min(low, it->first);
+            high = std::max(high, it->second);
+            it = m_received.erase(it);
+        }
+        m_received.emplace(low, high);
+        return fresh;
+    }
+
+    void Rx(Ptr<const Packet> packet, const Address& from)
+    {
+        uint64_t fresh = 0;
+        bool tagged = false;
+        ByteTagIterator tags = packet->GetByteTagIterator();
+        while (tags.HasNext())
+        {
+            ByteTagIterator::Item item = tags.Next();
+            if (item.GetTypeId() != DataSequenceTag::GetTypeId())
+            {
+                continue;
+            }
+            DataSequenceTag tag;
+            item.GetTag(tag);
+            Chunk& chunk = m_chunks[from];
+            if (!chunk.started || chunk.sequence != tag.GetSequence())
+            {
+                chunk = Chunk{tag.GetSequence(), 0, true};
+            }
+            uint64_t begin = chunk.sequence + chunk.delivered;
+            uint64_t length = item.GetEnd() - item.GetStart();
+            chunk.delivered += length;
+            fresh += Cover(begin, begin + length);
+            tagged = true;
+        }
+        if (!tagged)
+        {
+            fresh = packet->GetSize();
+        }
+        m_duplicates += packet->GetSize() - fresh;
+        if (fresh == 0)
+        {
+            return;
+        }
+        Time now = Simulator::Now();
+        if (m_bytes == 0)
+        {
+            m_first = now;
+        }
+        else if (now > m_failure)
+        {
+            m_maxStall = std::max(m_maxStall, now - std::max(m_last, m_failure));
+        }
+        m_last = now;
+        m_bytes += fresh;
+    }
+
+    Time m_failure;                          //!< Failure time
+    uint64_t m_bytes{0};                     //!< Unique bytes received
+    uint64_t m_duplicates{0};                //!< Bytes received more than once
+    std::map<uint64_t, uint64_t> m_received; //!< Received transfer ranges, start -> end
+    std::map<Address, Chunk> m_chunks;       //!< Chunk in delivery per sender address
+    Time m_first;                            //!< First reception
+    Time m_last;                             //!< Last reception
+    Time m_maxStall;                         //!< Longest gap since the failure
+};
+
+} // namespace ns3
+
+#endif /* WAN_MULTIPATH_H */
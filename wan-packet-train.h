@@ -0,0 +1,181 @@
+#ifndef WAN_PACKET_TRAIN_H
+#define WAN_PACKET_TRAIN_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <algorithm>
+#include <deque>
+#include <ostream>
+
+namespace ns3
+{
+
+/**
+ * @brief Point-to-point channel that hands arrivals over as packet trains.
+ *
+ * The stock channel schedules one receive event per packet as soon as the
+ * packet starts transmission, so a back-to-back burst keeps one pending
+ * event per packet in flight. This channel keeps, per direction, a FIFO of
+ * (packet, arrival time) computed arithmetically from the transmission
+ * time and delay, and at most one pending event: when it fires it delivers
+ * every packet that has arrived by then and re-arms for the next one.
+ *
+ * With a zero TrainWindow each packet is delivered at exactly the time the
+ * stock channel would use, so results are unchanged. So is the number of
+ * receive events: back-to-back packets arrive one transmission time apart
+ * and each still gets its own event. Only the scheduler queue shrinks, to
+ * one pending event per direction instead of one per packet in flight. A
+ * positive window lets the event wait that long after the head of the
+ * train arrives and deliver all packets arrived by then together: receive
+ * events drop by about the window over the per-packet transmission time,
+ * at the price of delaying a packet by at most the window.
+ *
+ * The TxRxPointToPoint trace of PointToPointChannel does not fire for
+ * packets on this channel; its callback is private to the base class.
+ */
+class PointToPointTrainChannel : public PointToPointChannel
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::PointToPointTrainChannel")
+                .SetParent<PointToPointChannel>()
+                .AddConstructor<PointToPointTrainChannel>()
+                .AddAttribute("TrainWindow",
+                              "Extra wait after the head of a train arrives (0 = exact timing).",
+                              TimeValue(Seconds(0)),
+                              MakeTimeAccessor(&PointToPointTrainChannel::m_window),
+                              MakeTimeChecker(Seconds(0)));
+        return tid;
+    }
+
+    bool TransmitStart(Ptr<const Packet> p, Ptr<PointToPointNetDevice> src, Time txTime) override
+    {
+        NS_ASSERT(IsInitialized());
+        uint32_t wire = src == GetSource(0) ? 0 : 1;
+        Train& train = m_trains[wire];
+        train.items.push_back(Item{p->Copy(), Simulator::Now() + txTime + GetDelay()});
+        train.peak = std::max<uint64_t>(train.peak, train.items.size());
+        m_packets++;
+        if (!train.event.IsPending())
+        {
+            Arm(wire);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Write packets carried, delivery events and pending events.
+     *
+     * The stock channel runs one event per packet and keeps one pending per
+     * packet in flight, up to the longest train.
+     *
+     * @param os Output stream.
+     */
+    void Print(std::ostream& os) const
+    {
+        os << m_packets << " packets in " << m_events << " delivery events, "
+           << m_packets - std::min(m_packets, m_events) << " saved; pending events at most 1 "
+           << "per direction instead of up to " << std::max(m_trains[0].peak, m_trains[1].peak)
+           << "\n";
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        for (Train& train : m_trains)
+        {
+            train.event.Cancel();
+            train.items.clear();
+        }
+        PointToPointChannel::DoDispose();
+    }
+
+  private:
+    /// A packet on the wire.
+    struct Item
+    {
+        Ptr<Packet> packet; //!< Packet
+        Time arrival;       //!< Time its last bit reaches the far end
+    };
+
+    /// Packets in flight in one direction.
+    struct Train
+    {
+        std::deque<Item> items; //!< In arrival order
+        EventId event;          //!< Next delivery
+        uint64_t peak{0};       //!< Most packets in flight at once
+    };
+
+    void Arm(uint32_t wire)
+    {
+        Train& train = m_trains[wire];
+        Time at = train.items.front().arrival + m_window;
+        train.event = Simulator::ScheduleWithContext(GetDestination(wire)->GetNode()->GetId(),
+                                                     at - Simulator::Now(),
+                                                     &PointToPointTrainChannel::Deliver,
+                                                     this,
+                                                     wire);
+    }
+
+    void Deliver(uint32_t wire)
+    {
+        Train& train = m_trains[wire];
+        Ptr<PointToPointNetDevice> dst = GetDestination(wire);
+        Time now = Simulator::Now();
+        m_events++;
+        while (!train.items.empty() && train.items.front().arrival <= now)
+        {
+            // Pop first: the receiver may transmit on the other wire right away
+            Ptr<Packet> packet = train.items.front().packet;
+            train.items.pop_front();
+            dst->Receive(packet);
+        }
+        if (!train.items.empty())
+        {
+            Arm(wire);
+        }
+    }
+
+    Time m_window;         //!< Extra wait after the head arrives
+    Train m_trains[2];     //!< Per direction, indexed like the stock channel's wires
+    uint64_t m_packets{0}; //!< Packets carried
+    uint64_t m_events{0};  //!< Delivery events run
+};
+
+/**
+ * @brief Move a point-to-point link onto a PointToPointTrainChannel.
+ *
+ * Both devices are re-attached to a new channel with the old channel's
+ * delay. Call it before the simulation starts, with nothing in flight.
+ *
+ * @param devices The two devices of the link.
+ * @param window Train window (0 = exact timing).
+ * @return The new channel.
+ */
+inline Ptr<PointToPointTrainChannel>
+UsePacketTrains(NetDeviceContainer devices, Time window)
+{
+    Ptr<PointToPointNetDevice> a = DynamicCast<PointToPointNetDevice>(devices.Get(0));
+    Ptr<PointToPointNetDevice> b = DynamicCast<PointToPointNetDevice>(devices.Get(1));
+    NS_ABORT_MSG_IF(!a || !b, "Packet trains need two point-to-point devices");
+    TimeValue delay;
+    a->GetChannel()->GetAttribute("Delay", delay);
+    Ptr<PointToPointTrainChannel> channel = CreateObject<PointToPointTrainChannel>();
+    channel->SetAttribute("Delay", delay);
+    channel->SetAttribute("TrainWindow", TimeValue(window));
+    a->Attach(channel);
+    b->Attach(channel);
+    return channel;
+}
+
+} // namespace ns3
+
+#endif /* WAN_PACKET_TRAIN_H */
@@ -0,0 +1,464 @@
+#ifndef WAN_PARTITION_H
+#define WAN_PARTITION_H
+
+#include "wan-topology.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Multilevel k-way partitioner of WAN graphs for parallel simulation.
+ *
+ * METIS-style: the graph is coarsened by heavy-edge matching until it is
+ * small, cut into k parts of equal load along a breadth-first order, then
+ * uncoarsened level by level with greedy boundary refinement. Each node
+ * weighs its expected event load; each link weighs the inverse of its delay
+ * (a median-delay link weighs 4, capped at 1000), so short links stay inside
+ * a part and the links that are cut give a long lookahead.
+ *
+ * The speedup estimate is a conservative-synchronisation model per
+ * simulated second: sequentially the whole load is processed at the event
+ * cost; in parallel the most loaded part is, plus one barrier of the given
+ * sync cost per lookahead window.
+ */
+class WanPartitioner
+{
+  public:
+    /// Result of a partitioning.
+    struct Result
+    {
+        uint32_t parts{0};          //!< Number of parts
+        std::vector<uint32_t> part; //!< Part of every node
+        std::vector<double> load;   //!< Load of every part, events/s
+        uint64_t cutLinks{0};       //!< Links between parts
+        Time lookahead;             //!< Shortest delay of a cut link
+        double imbalance{1};        //!< Largest load over mean load
+        double speedup{1};          //!< Estimated parallel speedup
+        uint32_t levels{0};         //!< Coarsening levels
+        double milliseconds{0};     //!< Time taken by the partitioner
+
+        /**
+         * @brief Write the quality report.
+         *
+         * @param os Output stream.
+         * @param links Number of links of the graph.
+         */
+        void Print(std::ostream& os, size_t links) const
+        {
+            os << parts << " parts in " << milliseconds << " ms (" << levels << " levels)\n";
+            os << "Cut links: " << cutLinks << " of " << links << " ("
+               << (links ? 100.0 * cutLinks / links : 0) << "%)\n";
+            if (cutLinks > 0)
+            {
+                os << "Lookahead: " << lookahead.As(Time::US) << "\n";
+            }
+            os << "Load imbalance: " << imbalance << "\n";
+            os << "Estimated speedup: " << speedup << " on " << parts << " cores\n";
+        }
+    };
+
+    /**
+     * @param eventsPerLink Expected events per simulated second at each link end.
+     * @param eventCost Wall-clock cost of one event.
+     * @param syncCost Wall-clock cost of one synchronisation barrier.
+     */
+    WanPartitioner(double eventsPerLink, Time eventCost, Time syncCost)
+        : m_eventsPerLink(eventsPerLink),
+          m_eventCost(eventCost.GetSeconds()),
+          m_syncCost(syncCost.GetSeconds())
+    {
+    }
+
+    /**
+     * @brief Partition a graph.
+     *
+     * Node loads are one event per second plus eventsPerLink per link end.
+     *
+     * @param graph The graph.
+     * @param parts Number of parts, at least 1.
+     * @return The partition and its quality.
+     */
+    Result Partition(const WanGraph& graph, uint32_t parts) const
+    {
+        auto begin = std::chrono::steady_clock::now();
+        Result result;
+        result.parts = std::max<uint32_t>(parts, 1);
+        Level top = BuildTop(graph);
+
+        // Coarsen
+        std::vector<Level> levels;
+        levels.push_back(std::move(top));
+        uint32_t coarsenTo = std::max<uint32_t>(20 * result.parts, 100);
+        while (levels.back().Nodes() > coarsenTo)
+        {
+            Level coarse;
+            if (!Coarsen(levels.back(), coarsenTo, coarse))
+            {
+                break;
+            }
+            levels.push_back(std::move(coarse));
+        }
+        result.levels = levels.size() - 1;
+
+        // Split the coarsest graph, then project and refine back up
+        std::vector<uint32_t> part = InitialPartition(levels.back(), result.parts);
+        Refine(levels.back(), result.parts, part);
+        for (size_t l = levels.size() - 1; l > 0; --l)
+        {
+            const std::vector<uint32_t>& map = levels[l - 1].coarse;
+            std::vector<uint32_t> finer(map.size());
+            for (size_t v = 0; v < map.size(); ++v)
+            {
+                finer[v] = part[map[v]];
+            }
+            part.swap(finer);
+            Refine(levels[l - 1], result.parts, part);
+        }
+
+        // Quality
+        const Level& g = levels.front();
+        result.load.assign(result.parts, 0);
+        double total = 0;
+        for (uint32_t v = 0; v < g.Nodes(); ++v)
+        {
+            result.load[part[v]] += g.weight[v];
+            total += g.weight[v];
+        }
+        int64_t lookahead = std::numeric_limits<int64_t>::max();
+        for (const WanGraph::Edge& e : graph.edges)
+        {
+            if (part[e.u] != part[e.v])
+            {
+                result.cutLinks++;
+                lookahead = std::min(lookahead, e.delayNs);
+            }
+        }
+        result.lookahead = NanoSeconds(result.cutLinks ? lookahead : 0);
+        double maxLoad = *std::max_element(result.load.begin(), result.load.end());
+        result.imbalance = total > 0 ? maxLoad * result.parts / total : 1;
+        double windows = result.cutLinks ? 1e9 / std::max<int64_t>(lookahead, 1) : 0;
+        double sequential = total * m_eventCost;
+        double parallel = maxLoad * m_eventCost + (result.parts > 1 ? windows * m_syncCost : 0);
+        result.speedup = parallel > 0 ? sequential / parallel : 1;
+        result.part.swap(part);
+        result.milliseconds =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin)
+                .count();
+        return result;
+    }
+
+  private:
+    /// One level of the multilevel hierarchy, in compressed adjacency form.
+    struct Level
+    {
+        std::vector<uint32_t> start;      //!< Adjacency of v is [start[v], start[v + 1])
+        std::vector<uint32_t> adjacent;   //!< Neighbours
+        std::vector<uint32_t> linkWeight; //!< Weight of the link to each neighbour
+        std::vector<double> weight;       //!< Node weights
+        std::vector<uint32_t> coarse;     //!< Node of the next coarser level
+
+        uint32_t Nodes() const
+        {
+            return weight.size();
+        }
+    };
+
+    Level BuildTop(const WanGraph& graph) const
+    {
+        Level g;
+        uint32_t n = graph.nodes;
+        g.weight.assign(n, 1);
+        g.start.assign(n + 1, 0);
+        for (const WanGraph::Edge& e : graph.edges)
+        {
+            g.start[e.u + 1]++;
+            g.start[e.v + 1]++;
+            g.weight[e.u] += m_eventsPerLink;
+            g.weight[e.v] += m_eventsPerLink;
+        }
+        for (uint32_t v = 0; v < n; ++v)
+        {
+            g.start[v + 1] += g.start[v];
+        }
+        std::vector<int64_t> delays;
+        delays.reserve(graph.edges.size());
+        for (const WanGraph::Edge& e : graph.edges)
+        {
+            delays.push_back(e.delayNs);
+        }
+        double median = 1;
+        if (!delays.empty())
+        {
+            std::nth_element(delays.begin(), delays.begin() + delays.size() / 2, delays.end());
+            median = std::max<int64_t>(delays[delays.size() / 2], 1);
+        }
+        g.adjacent.resize(g.start[n]);
+        g.linkWeight.resize(g.start[n]);
+        std::vector<uint32_t> fill(g.start.begin(), g.start.end() - 1);
+        for (const WanGraph::Edge& e : graph.edges)
+        {
+            double weight = std::lround(4 * median / std::max<int64_t>(e.delayNs, 1));
+            uint32_t w = std::clamp<double>(weight, 1, 1000);
+            g.adjacent[fill[e.u]] = e.v;
+            g.linkWeight[fill[e.u]++] = w;
+            g.adjacent[fill[e.v]] = e.u;
+            g.linkWeight[fill[e.v]++] = w;
+        }
+        return g;
+    }
+
+    /**
+     * Heavy-edge matching, visiting nodes by increasing degree, then
+     * contraction of matched pairs. Parallel links merge by adding weights.
+     * Returns false when the graph no longer shrinks.
+     */
+    static bool Coarsen(Level& fine, uint32_t coarsenTo, Level& coarse)
+    {
+        uint32_t n = fine.Nodes();
+        double total = 0;
+        for (double w : fine.weight)
+        {
+            total += w;
+        }
+        double maxWeight = 1.5 * total / coarsenTo;
+
+        // Counting sort by degree
+        uint32_t maxDegree = 0;
+        for (uint32_t v = 0; v < n; ++v)
+        {
+            maxDegree = std::max(maxDegree, fine.start[v + 1] - fine.start[v]);
+        }
+        std::vector<uint32_t> bucket(maxDegree + 2, 0);
+        for (uint32_t v = 0; v < n; ++v)
+        {
+            bucket[fine.start[v + 1] - fine.start[v] + 1]++;
+        }
+        for (uint32_t d = 0; d <= maxDegree; ++d)
+        {
+            bucket[d + 1] += bucket[d];
+        }
+        std::vector<uint32_t> order(n);
+        for (uint32_t v = 0; v < n; ++v)
+        {
+            order[bucket[fine.start[v + 1] - fine.start[v]]++] = v;
+        }
+
+        const uint32_t unmatched = UINT32_MAX;
+        fine.coarse.assign(n, unmatched);
+        uint32_t nc = 0;
+        for (uint32_t v : order)
+        {
+            if (fine.coarse[v] != unmatched)
+            {
+                continue;
+            }
+            uint32_t best = v;
+            uint32_t bestWeight = 0;
+            for (uint32_t i = fine.start[v]; i < fine.start[v + 1]; ++i)
+            {
+                uint32_t u = fine.adjacent[i];
+                if (fine.coarse[u] == unmatched && u != v && fine.linkWeight[i] > bestWeight &&
+                    fine.weight[u] + fine.weight[v] <= maxWeight)
+                {
+                    best = u;
+                    bestWeight = fine.linkWeight[i];
+                }
+            }
+            fine.coarse[v] = nc;
+            fine.coarse[best] = nc;
+            ++nc;
+        }
+        if (nc > 0.95 * n)
+        {
+            fine.coarse.clear();
+            return false;
+        }
+
+        // Contract, merging links to the same coarse neighbour through a marker array
+        coarse.weight.assign(nc, 0);
+        for (uint32_t v = 0; v < n; ++v)
+        {
+            coarse.weight[fine.coarse[v]] += fine.weight[v];
+        }
+        std::vector<uint32_t> first(nc + 1, 0);
+        for (uint32_t v = 0; v < n; ++v)
+        {
+            first[fine.coarse[v] + 1]++;
+        }
+        for (uint32_t c = 0; c < nc; ++c)
+        {
+            first[c + 1] += first[c];
+        }
+        std::vector<uint32_t> byCoarse(n);
+        std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+        for (uint32_t v = 0; v < n; ++v)
+        {
+            byCoarse[fill[fine.coarse[v]]++] = v;
+        }
+        std::vector<uint32_t> slot(nc, UINT32_MAX);
+        coarse.start.assign(1, 0);
+        coarse.start.reserve(nc + 1);
+        coarse.adjacent.reserve(fine.adjacent.size() / 2);
+        coarse.linkWeight.reserve(fine.adjacent.size() / 2);
+        for (uint32_t c = 0; c < nc; ++c)
+        {
+            uint32_t rowBegin = coarse.adjacent.size();
+            for (uint32_t k = first[c]; k < first[c + 1]; ++k)
+            {
+                uint32_t v = byCoarse[k];
+                for (uint32_t i = fine.start[v]; i < fine.start[v + 1]; ++i)
+                {
+                    uint32_t cu = fine.coarse[fine.adjacent[i]];
+                    if (cu == c)
+                    {
+                        continue;
+                    }
+                    if (slot[cu] == UINT32_MAX || slot[cu] < rowBegin)
+                    {
+                        slot[cu] = coarse.adjacent.size();
+                        coarse.adjacent.push_back(cu);
+                        coarse.linkWeight.push_back(fine.linkWeight[i]);
+                    }
+                    else
+                    {
+                        coarse.linkWeight[slot[cu]] += fine.linkWeight[i];
+                    }
+                }
+            }
+            coarse.start.push_back(coarse.adjacent.size());
+        }
+        return true;
+    }
+
+    /// Contiguous chunks of equal load along a breadth-first order, component by component.
+    static std::vector<uint32_t> InitialPartition(const Level& g, uint32_t parts)
+    {
+        uint32_t n = g.Nodes();
+        double total = 0;
+        for (double w : g.weight)
+        {
+            total += w;
+        }
+        std::vector<uint32_t> part(n, UINT32_MAX);
+        std::vector<uint32_t> queue;
+        queue.reserve(n);
+        double done = 0;
+        for (uint32_t root = 0; root < n; ++root)
+        {
+            if (part[root] != UINT32_MAX)
+            {
+                continue;
+            }
+            size_t head = queue.size();
+            queue.push_back(root);
+            part[root] = 0;
+            while (head < queue.size())
+            {
+                uint32_t v = queue[head++];
+                part[v] = std::min<uint32_t>(parts - 1, (done + g.weight[v] / 2) * parts / total);
+                done += g.weight[v];
+                for (uint32_t i = g.start[v]; i < g.start[v + 1]; ++i)
+                {
+                    uint32_t u = g.adjacent[i];
+                    if (part[u] == UINT32_MAX)
+                    {
+                        part[u] = 0;
+                        queue.push_back(u);
+                    }
+                }
+            }
+        }
+        return part;
+    }
+
+    /**
+     * Greedy k-way boundary refinement: move a node to the neighbouring part
+     * it is most connected to when that reduces the cut without breaking
+     * the 3% balance bound, keeps the cut and improves balance, or takes it
+     * out of an overloaded part.
+     */
+    static void Refine(const Level& g, uint32_t parts, std::vector<uint32_t>& part)
+    {
+        uint32_t n = g.Nodes();
+        std::vector<double> load(parts, 0);
+        double total = 0;
+        for (uint32_t v = 0; v < n; ++v)
+        {
+            load[part[v]] += g.weight[v];
+            total += g.weight[v];
+        }
+        double maxLoad = 1.03 * total / parts;
+        std::vector<int64_t> connection(parts, 0);
+        std::vector<uint32_t> touched;
+        for (uint32_t pass = 0; pass < 8; ++pass)
+        {
+            uint64_t moves = 0;
+            for (uint32_t v = 0; v < n; ++v)
+            {
+                uint32_t own = part[v];
+                touched.clear();
+                bool boundary = false;
+                for (uint32_t i = g.start[v]; i < g.start[v + 1]; ++i)
+                {
+                    uint32_t p = part[g.adjacent[i]];
+                    if (connection[p] == 0)
+                    {
+                        touched.push_back(p);
+                    }
+                    connection[p] += g.linkWeight[i];
+                    boundary |= p != own;
+                }
+                if (boundary || load[own] > maxLoad)
+                {
+                    uint32_t best = own;
+                    int64_t bestGain = std::numeric_limits<int64_t>::min();
+                    for (uint32_t p : touched)
+                    {
+                        int64_t gain = connection[p] - connection[own];
+                        if (p != own && load[p] + g.weight[v] <= maxLoad &&
+                            (gain > bestGain || (gain == bestGain && load[p] < load[best])))
+                        {
+                            best = p;
+                            bestGain = gain;
+                        }
+                    }
+                    if (best != own &&
+                        (bestGain > 0 || (bestGain == 0 && load[best] + g.weight[v] < load[own]) ||
+                         load[own] > maxLoad))
+                    {
+                        load[own] -= g.weight[v];
+                        load[best] += g.weight[v];
+                        part[v] = best;
+                        ++moves;
+                    }
+                }
+                for (uint32_t p : touched)
+                {
+                    connection[p] = 0;
+                }
+            }
+            if (moves == 0)
+            {
+                break;
+            }
+        }
+    }
+
+    double m_eventsPerLink; //!< Events per simulated second at each link end
+    double m_eventCost;     //!< Seconds per event
+    double m_syncCost;      //!< Seconds per barrier
+};
+
+} // namespace ns3
+
+#endif /* WAN_PARTITION_H */
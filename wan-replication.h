@@ -0,0 +1,218 @@
+#ifndef WAN_REPLICATION_H
+#define WAN_REPLICATION_H
+
+#include "wan-topology.h"
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Replications of the graph failover experiment on one built topology.
+ *
+ * The topology, Internet stacks, addresses, global routes, echo server and
+ * probe socket are set up once. Simulated time cannot be rewound, so each
+ * replication runs in its own epoch after Reset(), which returns the
+ * mutable state to its initial values: the link failed by the previous
+ * replication comes back up and the routes are recomputed, device queues
+ * are flushed, probe counters are cleared, and the random stream that picks
+ * the failed link is reseeded with the replication's run number. The
+ * replication then fails one random link of the primary path and measures
+ * the outage seen by 20 ms probes.
+ */
+class WanReplicationRunner
+{
+  public:
+    /// Outcome of one replication.
+    struct Replication
+    {
+        uint32_t failedLink{0}; //!< Link failed
+        uint32_t sent{0};       //!< Probes sent
+        uint32_t answered{0};   //!< Probes answered
+        Time outage;            //!< Longest gap between answers
+    };
+
+    /**
+     * @brief Set up the topology, routes and probes once.
+     *
+     * @param graph The graph; node 0 must have a link.
+     */
+    WanReplicationRunner(const WanGraph& graph)
+        : m_topology(BuildWanTopology(graph))
+    {
+        m_server = FindFarthestNode(graph, m_path);
+        NS_ABORT_MSG_IF(m_path.empty(), "Node 0 has no links to fail over");
+        Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+        UdpEchoServerHelper echoServer(9);
+        echoServer.Install(m_topology.nodes.Get(m_server)).Start(Seconds(0));
+        Ipv4Address serverAddress =
+            m_topology.nodes.Get(m_server)->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
+        m_socket = Socket::CreateSocket(m_topology.nodes.Get(0), UdpSocketFactory::GetTypeId());
+        m_socket->Connect(InetSocketAddress(serverAddress, 9));
+        m_socket->SetRecvCallback(MakeCallback(&WanReplicationRunner::Receive, this));
+        m_random = CreateObject<UniformRandomVariable>();
+    }
+
+    /**
+     * @brief Return the scenario to its initial state for a new replication.
+     *
+     * @param run Run number used to reseed the random stream.
+     */
+    void Reset(uint32_t run)
+    {
+        if (m_failed)
+        {
+            SetLink(m_failedLink, true);
+            Ipv4GlobalRoutingHelper::RecomputeRoutingTables();
+            m_failed = false;
+        }
+        for (const Ptr<PointToPointNetDevice>& device : m_topology.devices)
+        {
+            device->GetQueue()->Flush();
+        }
+        m_sent = 0;
+        m_answers.clear();
+        RngSeedManager::SetRun(run);
+        m_random->SetStream(0);
+    }
+
+    /**
+     * @brief Run one replication from the current simulation time.
+     *
+     * @param run Run number.
+     * @return The outcome.
+     */
+    Replication Run(uint32_t run)
+    {
+        Reset(run);
+        Time epoch = Simulator::Now();
+        m_failedLink = m_path[m_random->GetInteger(0, m_path.size() - 1)];
+        for (uint32_t i = 0; i < PROBES; ++i)
+        {
+            Simulator::Schedule(MilliSeconds(100 + 20 * i), &WanReplicationRunner::Probe, this);
+        }
+        Simulator::Schedule(MilliSeconds(500), &WanReplicationRunner::Fail, this);
+        Simulator::Schedule(MilliSeconds(550), &Ipv4GlobalRoutingHelper::RecomputeRoutingTables);
+        // Late replies drain before the next epoch
+        Simulator::Stop(MilliSeconds(100 + 20 * PROBES + 500));
+        Simulator::Run();
+
+        Replication result;
+        result.failedLink = m_failedLink;
+        result.sent = m_sent;
+        result.answered = m_answers.size();
+        Time last = epoch + MilliSeconds(100);
+        for (Time t : m_answers)
+        {
+            result.outage = std::max(result.outage, t - last);
+            last = t;
+        }
+        result.outage = std::max(result.outage, epoch + MilliSeconds(80 + 20 * PROBES) - last);
+        return result;
+    }
+
+  private:
+    static constexpr uint32_t PROBES = 100; //!< Probes per replication
+
+    void Probe()
+    {
+        m_socket->Send(Create<Packet>(64));
+        m_sent++;
+    }
+
+    void Receive(Ptr<Socket> socket)
+    {
+        while (socket->Recv())
+        {
+            m_answers.push_back(Simulator::Now());
+        }
+    }
+
+    void Fail()
+    {
+        SetLink(m_failedLink, false);
+        m_failed = true;
+    }
+
+    void SetLink(uint32_t link, bool up)
+    {
+        for (uint32_t side = 0; side < 2; ++side)
+        {
+            Ptr<NetDevice> device = m_topology.devices[2 * link + side];
+            Ptr<Ipv4> ipv4 = device->GetNode()->GetObject<Ipv4>();
+            uint32_t interface = ipv4->GetInterfaceForDevice(device);
+            if (up)
+            {
+                ipv4->SetUp(interface);
+            }
+            else
+            {
+                ipv4->SetDown(interface);
+            }
+        }
+    }
+
+    WanTopology m_topology;              //!< Nodes and devices
+    std::vector<uint32_t> m_path;        //!< Primary path links
+    uint32_t m_server{0};                //!< Echo server node
+    Ptr<Socket> m_socket;                //!< Probe socket on node 0
+    Ptr<UniformRandomVariable> m_random; //!< Picks the failed link
+    uint32_t m_failedLink{0};            //!< Link failed in this replication
+    bool m_failed{false};                //!< True while m_failedLink is down
+    uint32_t m_sent{0};                  //!< Probes sent in this replication
+    std::vector<Time> m_answers;         //!< Reply times in this replication
+};
+
+/**
+ * @brief Run many failover replications on one built graph and summarise them.
+ *
+ * Like RunWanGraphScenario(), the caller tears the simulation down.
+ *
+ * @param graph The graph.
+ * @param replications Number of replications; run numbers are 1..replications.
+ * @param os Stream receiving the report.
+ */
+inline void
+RunWanGraphReplications(const WanGraph& graph, uint32_t replications, std::ostream& os)
+{
+    auto begin = std::chrono::steady_clock::now();
+    WanReplicationRunner runner(graph);
+    auto ready = std::chrono::steady_clock::now();
+    uint64_t sent = 0;
+    uint64_t answered = 0;
+    Time totalOutage;
+    Time maxOutage;
+    for (uint32_t run = 1; run <= replications; ++run)
+    {
+        WanReplicationRunner::Replication r = runner.Run(run);
+        sent += r.sent;
+        answered += r.answered;
+        totalOutage += r.outage;
+        maxOutage = std::max(maxOutage, r.outage);
+    }
+    auto done = std::chrono::steady_clock::now();
+    double setupMs = std::chrono::duration<double, std::milli>(ready - begin).count();
+    double runMs = std::chrono::duration<double, std::milli>(done - ready).count();
+    os << "Setup once: " << setupMs << " ms; " << replications << " replications in " << runMs
+       << " ms (" << runMs / std::max(replications, 1u) << " ms each)\n";
+    os << "Probes answered: " << answered << " of " << sent << "\n";
+    if (replications > 0)
+    {
+        os << "Outage: mean " << (totalOutage / int64_t(replications)).As(Time::MS) << ", max "
+           << maxOutage.As(Time::MS) << "\n";
+    }
+}
+
+} // namespace ns3
+
+#endif /* WAN_REPLICATION_H */
@@ -0,0 +1,254 @@
+#ifndef WAN_SCHEDULER_H
+#define WAN_SCHEDULER_H
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Event scheduler that stores and dispatches events by timestamp batch.
+ *
+ * Events with the same timestamp go into one contiguous bucket in
+ * insertion order, which is also uid order, so execution order is exactly
+ * that of the stock schedulers. Only distinct timestamps enter the priority
+ * queue: when thousands of events share a time, inserting one is an append
+ * and the whole batch is dispatched from one array, prefetching the next
+ * event while the current one runs. Emptied buckets are recycled with
+ * their capacity.
+ *
+ * Events are never regrouped by handler within a batch: ns-3 guarantees
+ * same-time events run in scheduling order, and scenarios rely on it.
+ */
+class SameTimeBatchScheduler : public Scheduler
+{
+  public:
+    /// Dispatch counters, over all instances.
+    struct Stats
+    {
+        uint64_t events{0};  //!< Events removed for execution
+        uint64_t batches{0}; //!< Distinct timestamps dispatched
+        uint64_t largest{0}; //!< Largest batch
+    };
+
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::SameTimeBatchScheduler")
+                                .SetParent<Scheduler>()
+                                .AddConstructor<SameTimeBatchScheduler>();
+        return tid;
+    }
+
+    /// @return The dispatch counters.
+    static Stats& GetStats()
+    {
+        static Stats stats;
+        return stats;
+    }
+
+    void Insert(const Event& ev) override
+    {
+        auto it = m_index.find(ev.key.m_ts);
+        uint32_t slot;
+        if (it == m_index.end())
+        {
+            slot = Allocate();
+            m_index.emplace(ev.key.m_ts, slot);
+            m_times.push(ev.key.m_ts);
+        }
+        else
+        {
+            slot = it->second;
+        }
+        m_buckets[slot].events.push_back(ev);
+    }
+
+    bool IsEmpty() const override
+    {
+        return m_times.empty();
+    }
+
+    Event PeekNext() const override
+    {
+        const Bucket& bucket = m_buckets[Top()];
+        return bucket.events[bucket.head];
+    }
+
+    Event RemoveNext() override
+    {
+        uint32_t slot = Top();
+        Bucket& bucket = m_buckets[slot];
+        Stats& stats = GetStats();
+        if (bucket.head == 0)
+        {
+            stats.batches++;
+            stats.largest = std::max<uint64_t>(stats.largest, bucket.events.size());
+        }
+        stats.events++;
+        Event ev = bucket.events[bucket.head++];
+        if (bucket.head < bucket.events.size())
+        {
+#if defined(__GNUC__)
+            __builtin_prefetch(bucket.events[bucket.head].impl);
+#endif
+        }
+        else
+        {
+            Release(slot, ev.key.m_ts);
+        }
+        return ev;
+    }
+
+    void Remove(const Event& ev) override
+    {
+        uint32_t slot = m_index.at(ev.key.m_ts);
+        Bucket& bucket = m_buckets[slot];
+        auto it = std::find_if(bucket.events.begin() + bucket.head,
+                               bucket.events.end(),
+                               [&ev](const Event& e) { return e.key.m_uid == ev.key.m_uid; });
+        NS_ASSERT(it != bucket.events.end());
+        bucket.events.erase(it);
+        if (bucket.head == bucket.events.size())
+        {
+            Release(slot, ev.key.m_ts);
+        }
+    }
+
+  private:
+    /// Events sharing one timestamp.
+    struct Bucket
+    {
+        std::vector<Event> events; //!< In insertion (uid) order
+        size_t head{0};            //!< Next event to dispatch
+    };
+
+    /// Slot of the earliest bucket.
+    uint32_t Top() const
+    {
+        if (m_topTime != m_times.top() || m_topSlot == UINT32_MAX)
+        {
+            m_topTime = m_times.top();
+            m_topSlot = m_index.at(m_topTime);
+        }
+        return m_topSlot;
+    }
+
+    uint32_t Allocate()
+    {
+        if (!m_free.empty())
+        {
+            uint32_t slot = m_free.back();
+            m_free.pop_back();
+            return slot;
+        }
+        m_buckets.emplace_back();
+        return m_buckets.size() - 1;
+    }
+
+    /// Drop an emptied bucket; it is always the earliest or a removed one.
+    void Release(uint32_t slot, uint64_t ts)
+    {
+        Bucket& bucket = m_buckets[slot];
+        bucket.events.clear();
+        bucket.head = 0;
+        m_free.push_back(slot);
+        m_index.erase(ts);
+        if (!m_times.empty() && m_times.top() == ts)
+        {
+            m_times.pop();
+        }
+        else
+        {
+            m_removedTimes.push(ts);
+        }
+        // Lazily drop timestamps whose bucket was emptied by Remove()
+        while (!m_times.empty() && !m_removedTimes.empty() &&
+               m_times.top() == m_removedTimes.top())
+        {
+            m_times.pop();
+            m_removedTimes.pop();
+        }
+        m_topSlot = UINT32_MAX;
+    }
+
+    using MinHeap = std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>>;
+
+    std::vector<Bucket> m_buckets;                  //!< Bucket pool
+    std::vector<uint32_t> m_free;                   //!< Unused bucket slots
+    std::unordered_map<uint64_t, uint32_t> m_index; //!< Timestamp -> bucket slot
+    MinHeap m_times;                                //!< Pending distinct timestamps
+    MinHeap m_removedTimes;                         //!< Timestamps emptied out of order
+    mutable uint64_t m_topTime{0};                  //!< Cached earliest timestamp
+    mutable uint32_t m_topSlot{UINT32_MAX};         //!< Cached bucket of m_topTime
+};
+
+/**
+ * @brief Self-rescheduling event of the scheduler benchmark.
+ *
+ * @param left Events still to run.
+ * @param step Gap to the next timestamp.
+ */
+inline void
+SchedulerBenchmarkEvent(uint64_t* left, Time step)
+{
+    if (*left > 0)
+    {
+        --*left;
+        Simulator::Schedule(step, &SchedulerBenchmarkEvent, left, step);
+    }
+}
+
+/**
+ * @brief Compare event rates of schedulers on a timestamp-heavy workload.
+ *
+ * @p width events share every timestamp: each one reschedules itself 1 us
+ * later until @p events have run. Each scheduler runs in a fresh simulator.
+ *
+ * @param events Events to run per scheduler.
+ * @param width Events per timestamp.
+ * @param os Stream receiving the report.
+ */
+inline void
+RunSchedulerBenchmark(uint64_t events, uint32_t width, std::ostream& os)
+{
+    os << "=== Scheduler Benchmark (" << events << " events, " << width
+       << " per timestamp) ===\n";
+    for (TypeId type : {MapScheduler::GetTypeId(),
+                        HeapScheduler::GetTypeId(),
+                        SameTimeBatchScheduler::GetTypeId()})
+    {
+        ObjectFactory factory;
+        factory.SetTypeId(type);
+        Simulator::SetScheduler(factory);
+        uint64_t left = events;
+        for (uint32_t i = 0; i < width; ++i)
+        {
+            Simulator::Schedule(MicroSeconds(1), &SchedulerBenchmarkEvent, &left, MicroSeconds(1));
+        }
+        auto begin = std::chrono::steady_clock::now();
+        Simulator::Run();
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        uint64_t executed = Simulator::GetEventCount();
+        os << type.GetName() << ": " << executed << " events in " << seconds * 1000 << " ms, "
+           << executed / seconds << " events/s\n";
+        Simulator::Destroy();
+    }
+}
+
+} // namespace ns3
+
+#endif /* WAN_SCHEDULER_H */
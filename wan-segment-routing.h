@@ -0,0 +1,565 @@
+#ifndef WAN_SEGMENT_ROUTING_H
+#define WAN_SEGMENT_ROUTING_H
+
+#include "wan-tilfa.h"
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Segment list carried by a packet inside the SR domain.
+ *
+ * Labels are 16 bit: node SIDs start at SrDomain::NODE_SID_BASE and
+ * adjacency SIDs at SrDomain::ADJ_SID_BASE. A packet tag is limited to 21
+ * bytes, which leaves room for nine segments.
+ */
+class SegmentListTag : public Tag
+{
+  public:
+    /// Largest number of segments a tag can hold.
+    static constexpr uint32_t MAX_SEGMENTS = 9;
+
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::SegmentListTag")
+                                .SetParent<Tag>()
+                                .AddConstructor<SegmentListTag>();
+        return tid;
+    }
+
+    TypeId GetInstanceTypeId() const override
+    {
+        return GetTypeId();
+    }
+
+    uint32_t GetSerializedSize() const override
+    {
+        return 2 + 2 * m_count;
+    }
+
+    void Serialize(TagBuffer i) const override
+    {
+        i.WriteU8(m_count);
+        i.WriteU8(m_active);
+        for (uint8_t s = 0; s < m_count; ++s)
+        {
+            i.WriteU16(m_labels[s]);
+        }
+    }
+
+    void Deserialize(TagBuffer i) override
+    {
+        m_count = i.ReadU8();
+        m_active = i.ReadU8();
+        for (uint8_t s = 0; s < m_count; ++s)
+        {
+            m_labels[s] = i.ReadU16();
+        }
+    }
+
+    void Print(std::ostream& os) const override
+    {
+        os << "segments=";
+        for (uint8_t s = 0; s < m_count; ++s)
+        {
+            os << (s == m_active ? "[" : "") << m_labels[s] << (s == m_active ? "] " : " ");
+        }
+    }
+
+    /// @return True once every segment has been processed.
+    bool IsDone() const
+    {
+        return m_active >= m_count;
+    }
+
+    /// @return The active label.
+    uint16_t GetActive() const
+    {
+        return m_labels[m_active];
+    }
+
+    /// Move to the next segment.
+    void Next()
+    {
+        m_active++;
+    }
+
+    /**
+     * @brief Append a label at the end of the list.
+     * @param label The label.
+     * @return False if the list is full.
+     */
+    bool Append(uint16_t label)
+    {
+        if (m_count == MAX_SEGMENTS)
+        {
+            return false;
+        }
+        m_labels[m_count++] = label;
+        return true;
+    }
+
+    /**
+     * @brief Insert labels in front of the active segment.
+     * @param labels Labels to insert, first becomes active.
+     * @return False if they do not fit.
+     */
+    bool Push(const std::vector<uint16_t>& labels)
+    {
+        if (m_count + labels.size() > MAX_SEGMENTS)
+        {
+            return false;
+        }
+        std::copy_backward(m_labels + m_active,
+                           m_labels + m_count,
+                           m_labels + m_count + labels.size());
+        std::copy(labels.begin(), labels.end(), m_labels + m_active);
+        m_count += labels.size();
+        return true;
+    }
+
+  private:
+    uint8_t m_count{0};                  //!< Number of labels
+    uint8_t m_active{0};                 //!< Index of the active label
+    uint16_t m_labels[MAX_SEGMENTS]{};   //!< Segment list
+};
+
+/**
+ * @brief Segment routing domain over a set of nodes.
+ *
+ * Discovers the point-to-point adjacencies between the nodes, computes
+ * the primary next hops and TI-LFA repair lists with a TiLfaCalculator,
+ * and forwards segment-routed packets for every member node. Forwarding
+ * is an array lookup on the active label; when the primary adjacency of a
+ * node segment is down the precomputed repair list is pushed in the same
+ * forwarding decision.
+ */
+class SrDomain : public SimpleRefCount<SrDomain>
+{
+  public:
+    /// First node SID.
+    static constexpr uint16_t NODE_SID_BASE = 16000;
+    /// First adjacency SID.
+    static constexpr uint16_t ADJ_SID_BASE = 24000;
+
+    /**
+     * @param nodes Member nodes; node SID n is assigned to nodes.Get(n).
+     */
+    explicit SrDomain(NodeContainer nodes)
+        : m_calc(nodes.GetN())
+    {
+        NS_ABORT_MSG_IF(nodes.GetN() > ADJ_SID_BASE - NODE_SID_BASE, "Too many SR nodes");
+        for (uint32_t n = 0; n < nodes.GetN(); ++n)
+        {
+            m_index[nodes.Get(n)->GetId()] = n;
+            m_ipv4.push_back(nodes.Get(n)->GetObject<Ipv4>());
+        }
+        std::map<Ptr<Channel>, bool> seen;
+        for (uint32_t n = 0; n < nodes.GetN(); ++n)
+        {
+            Ptr<Ipv4> ipv4 = m_ipv4[n];
+            for (uint32_t i = 1; i < ipv4->GetNInterfaces(); ++i)
+            {
+                Ptr<NetDevice> device = ipv4->GetNetDevice(i);
+                Ptr<Channel> channel = device->GetChannel();
+                if (!channel || channel->GetNDevices() != 2 || seen[channel])
+                {
+                    continue;
+                }
+                Ptr<NetDevice> peer = channel->GetDevice(0) == device ? channel->GetDevice(1)
+                                                                      : channel->GetDevice(0);
+                auto it = m_index.find(peer->GetNode()->GetId());
+                if (it == m_index.end())
+                {
+                    continue;
+                }
+                seen[channel] = true;
+                uint32_t m = it->second;
+                uint32_t j = m_ipv4[m]->GetInterfaceForDevice(peer);
+                m_calc.AddLink(n, m, 1);
+                m_links.push_back(Link{i, m_ipv4[m]->GetAddress(j, 0).GetLocal(), true});
+                m_links.push_back(Link{j, ipv4->GetAddress(i, 0).GetLocal(), true});
+            }
+        }
+        NS_ABORT_MSG_IF(m_links.size() > uint32_t(0xffff - ADJ_SID_BASE),
+                        "Too many SR adjacencies");
+    }
+
+    /**
+     * @brief Compute next hops and repair lists.
+     *
+     * @param threads Worker threads (0 uses the hardware concurrency).
+     * @return Wall-clock time of the computation.
+     */
+    double Compute(uint32_t threads)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        m_calc.Compute(threads);
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - begin).count();
+    }
+
+    /**
+     * @brief Steer traffic entering the domain at a node.
+     *
+     * @param headend Node pushing the segment list.
+     * @param network Destination network matched by the policy.
+     * @param mask Network mask.
+     * @param path Node indices to visit, the last one being the egress.
+     */
+    void AddPolicy(uint32_t headend,
+                   Ipv4Address network,
+                   Ipv4Mask mask,
+                   const std::vector<uint32_t>& path)
+    {
+        SegmentListTag tag;
+        for (uint32_t n : path)
+        {
+            NS_ABORT_MSG_IF(!tag.Append(NODE_SID_BASE + n), "Segment list too long");
+        }
+        m_policies[headend].push_back(Policy{network.CombineMask(mask), mask, tag});
+    }
+
+    /**
+     * @brief Mark the adjacency of a failed device as down.
+     *
+     * Only the owning node reacts, as with a real local failure detection.
+     *
+     * @param device The device that went down.
+     */
+    void LinkDown(Ptr<NetDevice> device)
+    {
+        auto it = m_index.find(device->GetNode()->GetId());
+        if (it == m_index.end())
+        {
+            return;
+        }
+        uint32_t interface = m_ipv4[it->second]->GetInterfaceForDevice(device);
+        const std::vector<TiLfaCalculator::Adjacency>& adj = m_calc.GetAdjacencies();
+        for (uint32_t a = 0; a < adj.size(); ++a)
+        {
+            if (adj[a].from == it->second && m_links[a].interface == interface)
+            {
+                m_links[a].up = false;
+            }
+        }
+    }
+
+    /**
+     * @param nodeId ns-3 node id.
+     * @return The node index in the domain.
+     */
+    uint32_t GetIndex(uint32_t nodeId) const
+    {
+        return m_index.at(nodeId);
+    }
+
+    /**
+     * @brief Find the policy of a headend matching a destination.
+     *
+     * @param self Node index.
+     * @param dest Destination address.
+     * @param[out] tag Segment list of the policy.
+     * @return True if a policy matched.
+     */
+    bool Classify(uint32_t self, Ipv4Address dest, SegmentListTag& tag) const
+    {
+        auto it = m_policies.find(self);
+        if (it == m_policies.end())
+        {
+            return false;
+        }
+        for (const Policy& policy : it->second)
+        {
+            if (dest.CombineMask(policy.mask) == policy.network)
+            {
+                tag = policy.segments;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief One forwarding decision on the active segment.
+     *
+     * @param self Node index.
+     * @param tag Segment list, updated in place.
+     * @param dest IP destination of the packet.
+     * @param[out] drop Set when the packet cannot be forwarded.
+     * @return The route to use, or null when the list is exhausted or on drop.
+     */
+    Ptr<Ipv4Route> Forward(uint32_t self, SegmentListTag& tag, Ipv4Address dest, bool& drop)
+    {
+        const std::vector<TiLfaCalculator::Adjacency>& adj = m_calc.GetAdjacencies();
+        bool repaired = false;
+        drop = false;
+        while (!tag.IsDone())
+        {
+            uint16_t label = tag.GetActive();
+            uint32_t a;
+            if (label >= ADJ_SID_BASE)
+            {
+                a = label - ADJ_SID_BASE;
+                if (a >= adj.size() || adj[a].from != self || !m_links[a].up)
+                {
+                    break;
+                }
+                tag.Next();
+                return MakeRoute(self, a, dest);
+            }
+            uint32_t target = label - NODE_SID_BASE;
+            if (target == self)
+            {
+                tag.Next();
+                continue;
+            }
+            a = target < m_calc.GetNNodes() ? m_calc.GetNextHop(self, target)
+                                            : TiLfaCalculator::NONE;
+            if (a == TiLfaCalculator::NONE)
+            {
+                break;
+            }
+            if (m_links[a].up)
+            {
+                return MakeRoute(self, a, dest);
+            }
+            // Local repair: push the TI-LFA list in front of the active segment
+            if (repaired || !m_calc.GetRepair(a, target, m_scratch))
+            {
+                break;
+            }
+            std::vector<uint16_t> labels;
+            for (const TiLfaCalculator::Segment& s : m_scratch)
+            {
+                labels.push_back(s.adjacency ? ADJ_SID_BASE + s.id : NODE_SID_BASE + s.id);
+            }
+            if (!tag.Push(labels))
+            {
+                break;
+            }
+            repaired = true;
+            m_repairs++;
+        }
+        drop = !tag.IsDone();
+        return nullptr;
+    }
+
+    /**
+     * @brief Write the domain size, computation result and repair count.
+     *
+     * @param os Output stream.
+     */
+    void Print(std::ostream& os) const
+    {
+        os << "SR domain: " << m_calc.GetNNodes() << " nodes, " << m_links.size()
+           << " adjacencies\n";
+        os << "TI-LFA local repairs: " << m_repairs << "\n";
+    }
+
+  private:
+    /// Local data of an adjacency.
+    struct Link
+    {
+        uint32_t interface;  //!< Output interface at the owner
+        Ipv4Address nextHop; //!< Neighbour address on the link
+        bool up;             //!< False once the owner saw it fail
+    };
+
+    /// Headend steering policy.
+    struct Policy
+    {
+        Ipv4Address network;     //!< Destination network
+        Ipv4Mask mask;           //!< Network mask
+        SegmentListTag segments; //!< Segment list pushed
+    };
+
+    Ptr<Ipv4Route> MakeRoute(uint32_t self, uint32_t a, Ipv4Address dest) const
+    {
+        Ptr<Ipv4> ipv4 = m_ipv4[self];
+        Ptr<Ipv4Route> route = Create<Ipv4Route>();
+        route->SetDestination(dest);
+        route->SetGateway(m_links[a].nextHop);
+        route->SetOutputDevice(ipv4->GetNetDevice(m_links[a].interface));
+        route->SetSource(ipv4->GetAddress(m_links[a].interface, 0).GetLocal());
+        return route;
+    }
+
+    TiLfaCalculator m_calc;                              //!< Paths and repair lists
+    std::map<uint32_t, uint32_t> m_index;                //!< ns-3 node id -> node index
+    std::vector<Ptr<Ipv4>> m_ipv4;                       //!< IPv4 per node index
+    std::vector<Link> m_links;                           //!< Per-adjacency local data
+    std::map<uint32_t, std::vector<Policy>> m_policies;  //!< Policies per headend
+    std::vector<TiLfaCalculator::Segment> m_scratch;     //!< Repair list buffer
+    uint64_t m_repairs{0};                               //!< Repair lists pushed
+};
+
+/**
+ * @brief Per-node routing protocol forwarding segment-routed packets.
+ *
+ * Packets without a segment list and not matching a headend policy are
+ * left to the next protocol of the Ipv4ListRouting.
+ */
+class Ipv4SegmentRouting : public Ipv4RoutingProtocol
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::Ipv4SegmentRouting")
+                                .SetParent<Ipv4RoutingProtocol>()
+                                .AddConstructor<Ipv4SegmentRouting>();
+        return tid;
+    }
+
+    /**
+     * @param domain The domain this node belongs to.
+     * @param self Index of this node in the domain.
+     */
+    void SetDomain(Ptr<SrDomain> domain, uint32_t self)
+    {
+        m_domain = domain;
+        m_self = self;
+    }
+
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                               const Ipv4Header& header,
+                               Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override
+    {
+        SegmentListTag tag;
+        if (!p || !m_domain->Classify(m_self, header.GetDestination(), tag))
+        {
+            return nullptr;
+        }
+        bool drop;
+        Ptr<Ipv4Route> route = m_domain->Forward(m_self, tag, header.GetDestination(), drop);
+        if (route)
+        {
+            p->ReplacePacketTag(tag);
+        }
+        sockerr = route ? Socket::ERROR_NOTERROR : Socket::ERROR_NOROUTETOHOST;
+        return route;
+    }
+
+    bool RouteInput(Ptr<const Packet> p,
+                    const Ipv4Header& header,
+                    Ptr<const NetDevice> idev,
+                    const UnicastForwardCallback& ucb,
+                    const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb,
+                    const ErrorCallback& ecb) override
+    {
+        SegmentListTag tag;
+        if (!p->PeekPacketTag(tag) && !m_domain->Classify(m_self, header.GetDestination(), tag))
+        {
+            return false;
+        }
+        bool drop;
+        Ptr<Ipv4Route> route = m_domain->Forward(m_self, tag, header.GetDestination(), drop);
+        // The list is state of the packet being forwarded (IpForward copies it afterwards)
+        Ptr<Packet> packet = ConstCast<Packet>(p);
+        if (route)
+        {
+            packet->ReplacePacketTag(tag);
+            ucb(route, p, header);
+            return true;
+        }
+        packet->RemovePacketTag(tag);
+        if (drop)
+        {
+            ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+            return true;
+        }
+        // Egress: plain IP forwarding takes over
+        return false;
+    }
+
+    void NotifyInterfaceUp(uint32_t interface) override
+    {
+    }
+
+    void NotifyInterfaceDown(uint32_t interface) override
+    {
+    }
+
+    void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void SetIpv4(Ptr<Ipv4> ipv4) override
+    {
+        m_ipv4 = ipv4;
+    }
+
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+                           Time::Unit unit = Time::S) const override
+    {
+        *stream->GetStream() << "Segment routing, node SID "
+                             << SrDomain::NODE_SID_BASE + m_self << "\n";
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_domain = nullptr;
+        m_ipv4 = nullptr;
+        Ipv4RoutingProtocol::DoDispose();
+    }
+
+  private:
+    Ptr<SrDomain> m_domain; //!< Shared domain state
+    Ptr<Ipv4> m_ipv4;       //!< IPv4 of the node
+    uint32_t m_self{0};     //!< Node index in the domain
+};
+
+/**
+ * @brief Create an SR domain over the nodes and install it on each of them.
+ *
+ * @param nodes Member nodes.
+ * @param threads Threads used for the TI-LFA computation.
+ * @param os Stream receiving the computation time.
+ * @return The domain.
+ */
+inline Ptr<SrDomain>
+InstallSegmentRouting(NodeContainer nodes, uint32_t threads, std::ostream& os)
+{
+    Ptr<SrDomain> domain = Create<SrDomain>(nodes);
+    double ms = domain->Compute(threads);
+    os << "TI-LFA computation: " << ms << " ms\n";
+    for (uint32_t n = 0; n < nodes.GetN(); ++n)
+    {
+        Ptr<Ipv4ListRouting> list =
+            DynamicCast<Ipv4ListRouting>(nodes.Get(n)->GetObject<Ipv4>()->GetRoutingProtocol());
+        NS_ABORT_MSG_IF(!list, "Segment routing needs the default Ipv4ListRouting");
+        Ptr<Ipv4SegmentRouting> sr = CreateObject<Ipv4SegmentRouting>();
+        sr->SetDomain(domain, n);
+        list->AddRoutingProtocol(sr, 15);
+    }
+    return domain;
+}
+
+} // namespace ns3
+
+#endif /* WAN_SEGMENT_ROUTING_H */
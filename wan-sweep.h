@@ -0,0 +1,155 @@
+#ifndef WAN_SWEEP_H
+#define WAN_SWEEP_H
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+/**
+ * @brief Run independent scenario variants concurrently from one set-up process.
+ *
+ * ns-3 keeps its simulator, scheduler and object registries in process-wide
+ * singletons, and Ptr reference counts are not atomic, so two scenarios
+ * cannot share one address space on threads. Instead each variant runs in a
+ * child forked once the process is initialised (libraries loaded, TypeIds
+ * registered, command line parsed): the children share that memory
+ * read-only through copy-on-write, without paying for exec, dynamic
+ * loading and static initialisation. The swept flag may change any part of
+ * the scenario, so each child then builds its own topology and
+ * applications; no scenario state is shared.
+ *
+ * A child's standard output goes to a pipe; the parent collects every
+ * variant's output in variant order, so the combined report does not
+ * depend on scheduling.
+ */
+class ScenarioSweep
+{
+  public:
+    /**
+     * @brief Fork the variants, at most @p workers at a time.
+     *
+     * In a child this returns at once with the variant to run; the child
+     * then carries on as a normal single run and its output is captured. In
+     * the parent it returns -1 once every child has exited.
+     *
+     * @param variants Number of variants.
+     * @param workers Concurrent children (0 = one per core).
+     * @return The variant in a child, -1 in the parent.
+     */
+    int Fork(uint32_t variants, uint32_t workers)
+    {
+        if (workers == 0)
+        {
+            workers = std::max(1u, std::thread::hardware_concurrency());
+        }
+        m_outputs.assign(variants, "");
+        m_status.assign(variants, 0);
+        std::cout.flush();
+        std::cerr.flush();
+
+        std::vector<Child> running;
+        uint32_t next = 0;
+        while (next < variants || !running.empty())
+        {
+            while (next < variants && running.size() < workers)
+            {
+                int fds[2];
+                NS_ABORT_MSG_IF(pipe(fds) != 0, "Cannot create a pipe for the sweep");
+                pid_t pid = fork();
+                NS_ABORT_MSG_IF(pid < 0, "Cannot fork a sweep worker");
+                if (pid == 0)
+                {
+                    close(fds[0]);
+                    for (const Child& other : running)
+                    {
+                        close(other.fd);
+                    }
+                    dup2(fds[1], STDOUT_FILENO);
+                    close(fds[1]);
+                    return next;
+                }
+                close(fds[1]);
+                running.push_back(Child{pid, fds[0], next++});
+            }
+
+            // Drain every pipe so that no child blocks on a full one
+            std::vector<pollfd> fds;
+            for (const Child& child : running)
+            {
+                fds.push_back(pollfd{child.fd, POLLIN, 0});
+            }
+            poll(fds.data(), fds.size(), -1);
+            for (size_t i = running.size(); i-- > 0;)
+            {
+                if (fds[i].revents == 0)
+                {
+                    continue;
+                }
+                char buffer[4096];
+                ssize_t n = read(running[i].fd, buffer, sizeof(buffer));
+                if (n > 0 || (n < 0 && errno == EINTR))
+                {
+                    m_outputs[running[i].variant].append(buffer, std::max<ssize_t>(n, 0));
+                    continue;
+                }
+                close(running[i].fd);
+                int status = 0;
+                waitpid(running[i].pid, &status, 0);
+                m_status[running[i].variant] = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+                running.erase(running.begin() + i);
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Get the captured standard output of a variant.
+     *
+     * @param variant Variant index.
+     * @return The output.
+     */
+    const std::string& GetOutput(uint32_t variant) const
+    {
+        return m_outputs[variant];
+    }
+
+    /**
+     * @brief Get the exit status of a variant.
+     *
+     * @param variant Variant index.
+     * @return The exit code, or -1 if the child was killed by a signal.
+     */
+    int GetStatus(uint32_t variant) const
+    {
+        return m_status[variant];
+    }
+
+  private:
+    /// A running child.
+    struct Child
+    {
+        pid_t pid;        //!< Process id
+        int fd;           //!< Read end of its output pipe
+        uint32_t variant; //!< Variant it runs
+    };
+
+    std::vector<std::string> m_outputs; //!< Output per variant
+    std::vector<int> m_status;          //!< Exit status per variant
+};
+
+} // namespace ns3
+
+#endif /* WAN_SWEEP_H */
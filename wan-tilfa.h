@@ -0,0 +1,346 @@
+#ifndef WAN_TILFA_H
+#define WAN_TILFA_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Shortest paths and TI-LFA repair lists for a segment routing domain.
+ *
+ * Nodes are 0..N-1 and every link is a pair of directed adjacencies. The
+ * calculator builds the primary next-hop adjacency of every node towards
+ * every other node, and for every adjacency the repair segment list a
+ * point of local repair pushes to reach each destination once that link
+ * has failed. Equal-cost ties go to the lower neighbour id, so the result
+ * does not depend on the thread count.
+ *
+ * A repair list follows the post-convergence path: it is the shortest list
+ * of node segments (and adjacency segments where no node segment fits)
+ * whose pre-failure forwarding never crosses the failed link.
+ */
+class TiLfaCalculator
+{
+  public:
+    /// Value of an unused adjacency or distance.
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    /// One direction of a link.
+    struct Adjacency
+    {
+        uint32_t from;    //!< Owning node
+        uint32_t to;      //!< Neighbour node
+        uint32_t cost;    //!< IGP metric
+        uint32_t reverse; //!< Adjacency of the opposite direction
+    };
+
+    /// Segment of a repair list.
+    struct Segment
+    {
+        bool adjacency; //!< True for an adjacency segment
+        uint32_t id;    //!< Node id or adjacency index
+    };
+
+    /**
+     * @param nodes Number of nodes.
+     */
+    explicit TiLfaCalculator(uint32_t nodes)
+        : m_nodes(nodes),
+          m_out(nodes)
+    {
+    }
+
+    /**
+     * @brief Add a bidirectional link.
+     *
+     * @param a First node.
+     * @param b Second node.
+     * @param cost Metric used in both directions.
+     * @return The index of the a->b adjacency; b->a is the next index.
+     */
+    uint32_t AddLink(uint32_t a, uint32_t b, uint32_t cost)
+    {
+        uint32_t ab = m_adj.size();
+        m_adj.push_back(Adjacency{a, b, cost, ab + 1});
+        m_adj.push_back(Adjacency{b, a, cost, ab});
+        m_out[a].push_back(ab);
+        m_out[b].push_back(ab + 1);
+        return ab;
+    }
+
+    /**
+     * @brief Compute primary next hops and all repair lists.
+     *
+     * Work is split by source node over the given number of threads; each
+     * thread only writes the rows of the nodes it owns.
+     *
+     * @param threads Worker threads (0 uses the hardware concurrency).
+     */
+    void Compute(uint32_t threads)
+    {
+        if (threads == 0)
+        {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        m_dist.assign(size_t(m_nodes) * m_nodes, NONE);
+        m_nextHop.assign(size_t(m_nodes) * m_nodes, NONE);
+        m_repair.assign(m_adj.size(), {});
+
+        // Phase 1: one SPF per node. Phase 2 reads every row, so it waits.
+        ParallelFor(threads, [this](uint32_t s) {
+            std::vector<uint32_t> first;
+            Spf(s, NONE, &m_dist[size_t(s) * m_nodes], first);
+            std::copy(first.begin(), first.end(), m_nextHop.begin() + size_t(s) * m_nodes);
+        });
+        ParallelFor(threads, [this](uint32_t s) {
+            for (uint32_t a : m_out[s])
+            {
+                ComputeRepair(a);
+            }
+        });
+    }
+
+    /// @return Number of nodes.
+    uint32_t GetNNodes() const
+    {
+        return m_nodes;
+    }
+
+    /// @return All adjacencies.
+    const std::vector<Adjacency>& GetAdjacencies() const
+    {
+        return m_adj;
+    }
+
+    /**
+     * @param from Source node.
+     * @param to Destination node.
+     * @return The primary adjacency from @p from towards @p to, or NONE.
+     */
+    uint32_t GetNextHop(uint32_t from, uint32_t to) const
+    {
+        return m_nextHop[size_t(from) * m_nodes + to];
+    }
+
+    /**
+     * @param from Source node.
+     * @param to Destination node.
+     * @return The pre-failure distance, or NONE if unreachable.
+     */
+    uint32_t GetDistance(uint32_t from, uint32_t to) const
+    {
+        return m_dist[size_t(from) * m_nodes + to];
+    }
+
+    /**
+     * @brief Repair list pushed at the owner of @p adjacency when it fails.
+     *
+     * @param adjacency The failed primary adjacency.
+     * @param destination Target node of the active segment.
+     * @param[out] segments The repair segments, first to be processed first.
+     * @return False if the destination is unreachable without the link.
+     */
+    bool GetRepair(uint32_t adjacency, uint32_t destination, std::vector<Segment>& segments) const
+    {
+        const RepairTable& table = m_repair[adjacency];
+        if (table.offsets.empty() || table.offsets[destination] == NONE)
+        {
+            return false;
+        }
+        uint32_t begin = table.offsets[destination];
+        uint32_t end = begin;
+        while (end < table.segments.size() && !(table.segments[end].adjacency == false &&
+                                                 table.segments[end].id == NONE))
+        {
+            ++end;
+        }
+        segments.assign(table.segments.begin() + begin, table.segments.begin() + end);
+        return true;
+    }
+
+  private:
+    /// Repair lists of one adjacency for all destinations it is primary for.
+    struct RepairTable
+    {
+        std::vector<uint32_t> offsets;  //!< Start in segments per destination, or NONE
+        std::vector<Segment> segments;  //!< Lists separated by a {false, NONE} marker
+    };
+
+    template <typename F>
+    void ParallelFor(uint32_t threads, F body)
+    {
+        std::atomic<uint32_t> next{0};
+        auto worker = [this, &next, &body]() {
+            for (uint32_t s = next++; s < m_nodes; s = next++)
+            {
+                body(s);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (uint32_t t = 1; t < threads; ++t)
+        {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& t : pool)
+        {
+            t.join();
+        }
+    }
+
+    /**
+     * Dijkstra from @p source, optionally ignoring one link (both directions).
+     * @p first receives the first adjacency of the chosen path per node and
+     * @p parent (if given) the last one.
+     */
+    void Spf(uint32_t source,
+             uint32_t excluded,
+             uint32_t* dist,
+             std::vector<uint32_t>& first,
+             std::vector<uint32_t>* parent = nullptr) const
+    {
+        uint32_t excludedReverse = excluded == NONE ? NONE : m_adj[excluded].reverse;
+        first.assign(m_nodes, NONE);
+        if (parent)
+        {
+            parent->assign(m_nodes, NONE);
+        }
+        std::fill(dist, dist + m_nodes, NONE);
+        using Item = std::pair<uint64_t, uint32_t>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> heap;
+        dist[source] = 0;
+        heap.emplace(0, source);
+        while (!heap.empty())
+        {
+            auto [d, u] = heap.top();
+            heap.pop();
+            if (d != dist[u])
+            {
+                continue;
+            }
+            for (uint32_t a : m_out[u])
+            {
+                if (a == excluded || a == excludedReverse)
+                {
+                    continue;
+                }
+                uint32_t v = m_adj[a].to;
+                uint64_t nd = d + m_adj[a].cost;
+                uint32_t via = u == source ? a : first[u];
+                // first[v] is NONE for the source itself, reachable again over zero-cost links
+                bool better = nd < dist[v] || (nd == dist[v] && first[v] != NONE &&
+                                               m_adj[via].to < m_adj[first[v]].to);
+                if (better)
+                {
+                    dist[v] = nd;
+                    first[v] = via;
+                    if (parent)
+                    {
+                        (*parent)[v] = a;
+                    }
+                    heap.emplace(nd, v);
+                }
+            }
+        }
+    }
+
+    /// True if pre-failure forwarding from @p from reaches @p to without using @p link.
+    bool AvoidsLink(uint32_t from, uint32_t to, uint32_t link) const
+    {
+        uint32_t reverse = m_adj[link].reverse;
+        for (uint32_t hops = 0; from != to; ++hops)
+        {
+            uint32_t a = GetNextHop(from, to);
+            if (a == NONE || a == link || a == reverse || hops > m_nodes)
+            {
+                return false;
+            }
+            from = m_adj[a].to;
+        }
+        return true;
+    }
+
+    void ComputeRepair(uint32_t link)
+    {
+        uint32_t plr = m_adj[link].from;
+        std::vector<uint32_t> dist(m_nodes);
+        std::vector<uint32_t> first;
+        std::vector<uint32_t> parent;
+        Spf(plr, link, dist.data(), first, &parent);
+
+        RepairTable& table = m_repair[link];
+        for (uint32_t d = 0; d < m_nodes; ++d)
+        {
+            if (d == plr || GetNextHop(plr, d) != link)
+            {
+                continue;
+            }
+            if (table.offsets.empty())
+            {
+                table.offsets.assign(m_nodes, NONE);
+            }
+            if (dist[d] == NONE)
+            {
+                continue;
+            }
+            // Post-convergence path plr -> d
+            std::vector<uint32_t> path{d};
+            while (path.back() != plr)
+            {
+                path.push_back(m_adj[parent[path.back()]].from);
+            }
+            std::reverse(path.begin(), path.end());
+
+            table.offsets[d] = table.segments.size();
+            uint32_t at = 0;
+            while (path[at] != d)
+            {
+                // Farthest node on the path reachable by a plain node segment
+                uint32_t reach = at;
+                for (uint32_t k = path.size() - 1; k > at; --k)
+                {
+                    if (AvoidsLink(path[at], path[k], link))
+                    {
+                        reach = k;
+                        break;
+                    }
+                }
+                if (reach > at)
+                {
+                    // The destination is the active segment already on the packet
+                    if (path[reach] != d)
+                    {
+                        table.segments.push_back(Segment{false, path[reach]});
+                    }
+                    at = reach;
+                }
+                else
+                {
+                    table.segments.push_back(Segment{true, parent[path[at + 1]]});
+                    at++;
+                }
+            }
+            table.segments.push_back(Segment{false, NONE});
+        }
+    }
+
+    uint32_t m_nodes;                              //!< Number of nodes
+    std::vector<Adjacency> m_adj;                  //!< Directed adjacencies
+    std::vector<std::vector<uint32_t>> m_out;      //!< Adjacencies leaving each node
+    std::vector<uint32_t> m_dist;                  //!< Distance matrix, row per source
+    std::vector<uint32_t> m_nextHop;               //!< Primary adjacency matrix
+    std::vector<RepairTable> m_repair;             //!< Repair lists per adjacency
+};
+
+} // namespace ns3
+
+#endif /* WAN_TILFA_H */
@@ -0,0 +1,342 @@
+#ifndef WAN_TOPOLOGY_GENERATOR_H
+#define WAN_TOPOLOGY_GENERATOR_H
+
+#include "wan-topology.h"
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Seeded generators of synthetic WAN graphs.
+ *
+ * All randomness comes from one splitmix64 stream seeded at construction and
+ * consumed in a fixed order, so a seed gives the same graph on every
+ * platform and standard library. Every generator runs in time linear in the
+ * nodes plus edges it produces. Links without a geometric length get the
+ * configured rate and a delay drawn uniformly from half to one and a half
+ * times the configured delay.
+ */
+class WanGraphGenerator
+{
+  public:
+    /**
+     * @param seed Seed of the random stream.
+     * @param rateBps Link rate in bit/s.
+     * @param delay Mean delay of links without coordinates.
+     */
+    WanGraphGenerator(uint64_t seed, uint64_t rateBps, Time delay)
+        : m_state(seed),
+          m_rate(rateBps),
+          m_delay(delay.GetNanoSeconds())
+    {
+    }
+
+    /**
+     * @brief Generate by name, as selected on the command line.
+     *
+     * @param model "waxman", "ba", "dualhub" or "mesh".
+     * @param nodes Number of nodes.
+     * @param degree Target mean degree (ignored by "dualhub").
+     * @param[out] graph The graph.
+     * @return False if the model is unknown.
+     */
+    bool Generate(const std::string& model, uint32_t nodes, double degree, WanGraph& graph)
+    {
+        if (model == "waxman")
+        {
+            Waxman(nodes, degree, 0.4, 4000, graph);
+        }
+        else if (model == "ba")
+        {
+            BarabasiAlbert(nodes, std::max<uint32_t>(1, std::lround(degree / 2)), graph);
+        }
+        else if (model == "dualhub")
+        {
+            DualHub(std::max<uint32_t>(nodes, 3) - 2, 10 * m_rate, graph);
+        }
+        else if (model == "mesh")
+        {
+            Mesh(nodes, nodes > 1 ? degree / (nodes - 1) : 1, graph);
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Waxman graph: nodes uniform in a square, link probability
+     * alpha * exp(-d / beta).
+     *
+     * beta is chosen from the node count so that the mean degree is about
+     * @p degree (a little less near the edges of the square). Pairs whose
+     * link probability is below 1e-4 are never drawn, which lets a grid of
+     * buckets limit the candidate pairs to neighbouring buckets. Delays
+     * follow the distance at 5 us per km.
+     *
+     * @param nodes Number of nodes.
+     * @param degree Target mean degree.
+     * @param alpha Link probability at distance 0, in (0, 1].
+     * @param regionKm Side of the square in km.
+     * @param[out] graph The graph.
+     */
+    void Waxman(uint32_t nodes, double degree, double alpha, double regionKm, WanGraph& graph)
+    {
+        NS_ABORT_MSG_IF(alpha <= 1e-4 || alpha > 1, "Waxman alpha must be in (1e-4, 1]");
+        graph = WanGraph();
+        graph.nodes = nodes;
+        std::vector<double> x(nodes);
+        std::vector<double> y(nodes);
+        for (uint32_t i = 0; i < nodes; ++i)
+        {
+            x[i] = Uniform();
+            y[i] = Uniform();
+        }
+        const double pi = 3.14159265358979323846;
+        double beta = std::sqrt(degree / (2 * pi * alpha * std::max<uint32_t>(nodes, 1)));
+        double cutoff = beta * std::log(alpha * 1e4);
+        double cutoff2 = cutoff * cutoff;
+        uint32_t cells = std::max<uint32_t>(1, std::min<double>(1 / cutoff, 4096));
+
+        // Counting sort of the nodes into cells
+        std::vector<uint32_t> start(cells * cells + 1, 0);
+        std::vector<uint32_t> cellOf(nodes);
+        for (uint32_t i = 0; i < nodes; ++i)
+        {
+            uint32_t cx = std::min<uint32_t>(x[i] * cells, cells - 1);
+            uint32_t cy = std::min<uint32_t>(y[i] * cells, cells - 1);
+            cellOf[i] = cy * cells + cx;
+            start[cellOf[i] + 1]++;
+        }
+        for (uint32_t c = 0; c < cells * cells; ++c)
+        {
+            start[c + 1] += start[c];
+        }
+        std::vector<uint32_t> members(nodes);
+        std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+        for (uint32_t i = 0; i < nodes; ++i)
+        {
+            members[fill[cellOf[i]]++] = i;
+        }
+
+        graph.edges.reserve(size_t(degree * nodes / 2 * 1.05));
+        auto tryPair = [&](uint32_t u, uint32_t v) {
+            double ddx = x[u] - x[v];
+            double ddy = y[u] - y[v];
+            double d2 = ddx * ddx + ddy * ddy;
+            if (d2 > cutoff2)
+            {
+                return;
+            }
+            double d = std::sqrt(d2);
+            if (Uniform() < alpha * std::exp(-d / beta))
+            {
+                int64_t delay = std::max<int64_t>(1000, d * regionKm * 5000);
+                graph.edges.push_back(WanGraph::Edge{u, v, m_rate, delay});
+            }
+        };
+        // Each unordered pair of cells is visited once: itself and four forward neighbours
+        const int32_t dx[] = {1, -1, 0, 1};
+        const int32_t dy[] = {0, 1, 1, 1};
+        for (uint32_t cy = 0; cy < cells; ++cy)
+        {
+            for (uint32_t cx = 0; cx < cells; ++cx)
+            {
+                uint32_t c = cy * cells + cx;
+                for (uint32_t i = start[c]; i < start[c + 1]; ++i)
+                {
+                    for (uint32_t j = i + 1; j < start[c + 1]; ++j)
+                    {
+                        tryPair(members[i], members[j]);
+                    }
+                }
+                for (uint32_t k = 0; k < 4; ++k)
+                {
+                    int32_t nx = int32_t(cx) + dx[k];
+                    int32_t ny = int32_t(cy) + dy[k];
+                    if (nx < 0 || nx >= int32_t(cells) || ny >= int32_t(cells))
+                    {
+                        continue;
+                    }
+                    uint32_t n = ny * cells + nx;
+                    for (uint32_t i = start[c]; i < start[c + 1]; ++i)
+                    {
+                        for (uint32_t j = start[n]; j < start[n + 1]; ++j)
+                        {
+                            tryPair(members[i], members[j]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Barabási-Albert preferential attachment.
+     *
+     * Starts from a clique of m + 1 nodes; every further node links to m
+     * distinct nodes chosen with probability proportional to their degree,
+     * by drawing from the list of all link endpoints.
+     *
+     * @param nodes Number of nodes, at least m + 1.
+     * @param m Links added per node.
+     * @param[out] graph The graph.
+     */
+    void BarabasiAlbert(uint32_t nodes, uint32_t m, WanGraph& graph)
+    {
+        graph = WanGraph();
+        nodes = std::max(nodes, m + 1);
+        graph.nodes = nodes;
+        graph.edges.reserve(size_t(m) * nodes);
+        std::vector<uint32_t> ends;
+        ends.reserve(2 * size_t(m) * nodes);
+        auto link = [&](uint32_t u, uint32_t v) {
+            graph.edges.push_back(WanGraph::Edge{u, v, m_rate, Delay()});
+            ends.push_back(u);
+            ends.push_back(v);
+        };
+        for (uint32_t u = 0; u <= m; ++u)
+        {
+            for (uint32_t v = u + 1; v <= m; ++v)
+            {
+                link(u, v);
+            }
+        }
+        std::vector<uint32_t> targets;
+        for (uint32_t v = m + 1; v < nodes; ++v)
+        {
+            targets.clear();
+            while (targets.size() < m)
+            {
+                uint32_t t = ends[Below(ends.size())];
+                if (std::find(targets.begin(), targets.end(), t) == targets.end())
+                {
+                    targets.push_back(t);
+                }
+            }
+            for (uint32_t t : targets)
+            {
+                link(v, t);
+            }
+        }
+    }
+
+    /**
+     * @brief Hub-and-spoke with two hubs, the HQ/DC design of ex.cc at scale.
+     *
+     * Nodes 0 and 1 are the hubs, joined by one link; every spoke has a
+     * link to each hub, so any single link failure leaves it connected.
+     *
+     * @param spokes Number of spokes.
+     * @param hubRateBps Rate of the hub interconnect.
+     * @param[out] graph The graph.
+     */
+    void DualHub(uint32_t spokes, uint64_t hubRateBps, WanGraph& graph)
+    {
+        graph = WanGraph();
+        graph.nodes = spokes + 2;
+        graph.edges.reserve(2 * size_t(spokes) + 1);
+        graph.edges.push_back(WanGraph::Edge{0, 1, hubRateBps, Delay()});
+        for (uint32_t s = 2; s < spokes + 2; ++s)
+        {
+            graph.edges.push_back(WanGraph::Edge{s, 0, m_rate, Delay()});
+            graph.edges.push_back(WanGraph::Edge{s, 1, m_rate, Delay()});
+        }
+    }
+
+    /**
+     * @brief Mesh: each pair linked with probability p (full mesh for p >= 1).
+     *
+     * Partial meshes skip over unlinked pairs with geometrically distributed
+     * gaps (Batagelj and Brandes), so the cost follows the links, not the
+     * n^2 pairs.
+     *
+     * @param nodes Number of nodes.
+     * @param p Link probability.
+     * @param[out] graph The graph.
+     */
+    void Mesh(uint32_t nodes, double p, WanGraph& graph)
+    {
+        graph = WanGraph();
+        graph.nodes = nodes;
+        if (p >= 1)
+        {
+            graph.edges.reserve(size_t(nodes) * (nodes - 1) / 2);
+            for (uint32_t v = 1; v < nodes; ++v)
+            {
+                for (uint32_t w = 0; w < v; ++w)
+                {
+                    graph.edges.push_back(WanGraph::Edge{v, w, m_rate, Delay()});
+                }
+            }
+            return;
+        }
+        if (p <= 0)
+        {
+            return;
+        }
+        graph.edges.reserve(size_t(p * nodes * (nodes - 1) / 2 * 1.05));
+        double logSkip = std::log(1 - p);
+        uint64_t v = 1;
+        int64_t w = -1;
+        while (v < nodes)
+        {
+            w += 1 + int64_t(std::log(1 - Uniform()) / logSkip);
+            while (w >= int64_t(v) && v < nodes)
+            {
+                w -= v;
+                ++v;
+            }
+            if (v < nodes)
+            {
+                graph.edges.push_back(WanGraph::Edge{uint32_t(v), uint32_t(w), m_rate, Delay()});
+            }
+        }
+    }
+
+  private:
+    /// Next value of the splitmix64 stream.
+    uint64_t Next()
+    {
+        m_state += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = m_state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /// Uniform in [0, 1) with 53 random bits.
+    double Uniform()
+    {
+        return (Next() >> 11) * 0x1.0p-53;
+    }
+
+    /// Uniform integer below @p bound.
+    uint64_t Below(uint64_t bound)
+    {
+        return Next() % bound;
+    }
+
+    /// Delay of a link without coordinates.
+    int64_t Delay()
+    {
+        return m_delay / 2 + int64_t(Uniform() * m_delay);
+    }
+
+    uint64_t m_state; //!< splitmix64 state
+    uint64_t m_rate;  //!< Link rate in bit/s
+    int64_t m_delay;  //!< Mean delay in ns
+};
+
+} // namespace ns3
+
+#endif /* WAN_TOPOLOGY_GENERATOR_H */
@@ -0,0 +1,824 @@
+#ifndef WAN_TOPOLOGY_H
+#define WAN_TOPOLOGY_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <istream>
+#include <ostream>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Compact WAN graph: dense node ids and one record per link.
+ */
+struct WanGraph
+{
+    /// Delay value meaning "derive from the node coordinates".
+    static constexpr int64_t FROM_DISTANCE = -1;
+
+    /// A bidirectional link.
+    struct Edge
+    {
+        uint32_t u;       //!< First node
+        uint32_t v;       //!< Second node
+        uint64_t rateBps; //!< Data rate in bit/s
+        int64_t delayNs;  //!< One-way delay in ns
+    };
+
+    uint32_t nodes{0};              //!< Number of nodes, ids 0..nodes-1
+    std::vector<Edge> edges;        //!< Links
+    std::vector<std::string> names; //!< Labels from the source file (may be empty)
+};
+
+/**
+ * @brief Streaming reader of WAN graphs.
+ *
+ * Supported formats:
+ *  - "edgelist": one "a b [rate] [delay]" link per line, '#' comments;
+ *  - "graphml": GraphML, including the Internet Topology Zoo files;
+ *  - "gml": GML as distributed by the Internet Topology Zoo.
+ *
+ * Files are read one tag, token or line at a time, so memory is bounded by
+ * the graph, not the file. Link rates come from LinkSpeedRaw (bit/s),
+ * LinkSpeed with LinkSpeedUnits, or a bandwidth/capacity/rate attribute;
+ * delays from a delay/latency attribute or, failing that, from the great
+ * circle distance between the node Latitude/Longitude at 5 us per km.
+ * Rates and delays accept unit suffixes ("10Mbps", "2ms"); a bare delay is
+ * in milliseconds. Anything missing takes the reader's defaults.
+ */
+class WanGraphReader
+{
+  public:
+    /**
+     * @param defaultRateBps Rate of links without a usable attribute.
+     * @param defaultDelay Delay of links without attribute or coordinates.
+     */
+    WanGraphReader(uint64_t defaultRateBps, Time defaultDelay)
+        : m_defaultRate(defaultRateBps),
+          m_defaultDelay(defaultDelay.GetNanoSeconds())
+    {
+    }
+
+    /**
+     * @brief Read a file.
+     *
+     * @param path File name.
+     * @param format "edgelist", "graphml", "gml", or "" to go by the extension.
+     * @param[out] graph The graph read.
+     * @return False if the file cannot be opened or the format is unknown.
+     */
+    bool Read(const std::string& path, std::string format, WanGraph& graph)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            return false;
+        }
+        if (format.empty())
+        {
+            std::string ext = path.substr(path.find_last_of('.') + 1);
+            format = ext == "graphml" || ext == "xml" ? "graphml"
+                     : ext == "gml"                   ? "gml"
+                                                      : "edgelist";
+        }
+        Reset(graph);
+        if (format == "edgelist")
+        {
+            ReadEdgeList(in);
+        }
+        else if (format == "graphml")
+        {
+            ReadGraphMl(in);
+        }
+        else if (format == "gml")
+        {
+            ReadGml(in);
+        }
+        else
+        {
+            return false;
+        }
+        Finish();
+        return true;
+    }
+
+    /**
+     * @brief Parse a data rate such as "1e9", "10M", "10Mbps" or "1 Gb/s".
+     *
+     * @param text Rate text; a bare number is in bit/s.
+     * @param[out] bps The rate.
+     * @return False if there is no leading number.
+     */
+    static bool ParseRate(const std::string& text, uint64_t& bps)
+    {
+        size_t end = 0;
+        double value = ParseNumber(text, end);
+        if (end == 0)
+        {
+            return false;
+        }
+        while (end < text.size() && text[end] == ' ')
+        {
+            ++end;
+        }
+        double scale = 1;
+        switch (end < text.size() ? text[end] : ' ')
+        {
+        case 'k':
+        case 'K':
+            scale = 1e3;
+            break;
+        case 'M':
+            scale = 1e6;
+            break;
+        case 'G':
+            scale = 1e9;
+            break;
+        case 'T':
+            scale = 1e12;
+            break;
+        }
+        bps = uint64_t(value * scale);
+        return true;
+    }
+
+    /**
+     * @brief Parse a delay such as "2ms", "150us" or "3.5" (milliseconds).
+     *
+     * @param text Delay text.
+     * @param[out] ns The delay in nanoseconds.
+     * @return False if there is no leading number.
+     */
+    static bool ParseDelay(const std::string& text, int64_t& ns)
+    {
+        size_t end = 0;
+        double value = ParseNumber(text, end);
+        if (end == 0)
+        {
+            return false;
+        }
+        std::string unit = text.substr(end);
+        unit.erase(0, unit.find_first_not_of(' '));
+        double scale = 1e6;
+        if (unit.compare(0, 2, "ns") == 0)
+        {
+            scale = 1;
+        }
+        else if (unit.compare(0, 2, "us") == 0)
+        {
+            scale = 1e3;
+        }
+        else if (unit.compare(0, 1, "s") == 0)
+        {
+            scale = 1e9;
+        }
+        ns = int64_t(value * scale);
+        return true;
+    }
+
+  private:
+    /// Attributes gathered for the element being parsed.
+    struct Pending
+    {
+        std::string source;     //!< Edge source id
+        std::string target;     //!< Edge target id
+        std::string id;         //!< Node id
+        std::string speed;      //!< LinkSpeed value
+        std::string speedUnits; //!< LinkSpeedUnits value
+        uint64_t rate{0};       //!< Rate, 0 if not given
+        int64_t delay{-1};      //!< Delay if given, else FROM_DISTANCE
+        double latitude{NAN};   //!< Node latitude
+        double longitude{NAN};  //!< Node longitude
+    };
+
+    static double ParseNumber(const std::string& text, size_t& end)
+    {
+        const char* begin = text.c_str();
+        while (*begin == ' ' || *begin == '"')
+        {
+            ++begin;
+        }
+        char* stop = nullptr;
+        double value = std::strtod(begin, &stop);
+        end = stop == begin ? 0 : stop - text.c_str();
+        return value;
+    }
+
+    void Reset(WanGraph& graph)
+    {
+        m_graph = &graph;
+        graph = WanGraph();
+        m_ids.clear();
+        m_latitude.clear();
+        m_longitude.clear();
+    }
+
+    uint32_t NodeId(const std::string& name)
+    {
+        auto it = m_ids.find(name);
+        if (it != m_ids.end())
+        {
+            return it->second;
+        }
+        uint32_t id = m_graph->nodes++;
+        m_ids.emplace(name, id);
+        m_graph->names.push_back(name);
+        m_latitude.push_back(NAN);
+        m_longitude.push_back(NAN);
+        return id;
+    }
+
+    /// Apply one attribute to the pending element; keys are matched case-insensitively.
+    void Attribute(Pending& p, std::string key, const std::string& value)
+    {
+        for (char& c : key)
+        {
+            c = std::tolower(static_cast<unsigned char>(c));
+        }
+        if (key == "linkspeedraw" || key == "bandwidth" || key == "capacity" || key == "rate")
+        {
+            ParseRate(value, p.rate);
+        }
+        else if (key == "linkspeed")
+        {
+            p.speed = value;
+        }
+        else if (key == "linkspeedunits")
+        {
+            p.speedUnits = value;
+        }
+        else if (key == "delay" || key == "latency")
+        {
+            ParseDelay(value, p.delay);
+        }
+        else if (key == "latitude")
+        {
+            p.latitude = std::strtod(value.c_str(), nullptr);
+        }
+        else if (key == "longitude")
+        {
+            p.longitude = std::strtod(value.c_str(), nullptr);
+        }
+    }
+
+    void CommitNode(const Pending& p)
+    {
+        uint32_t id = NodeId(p.id);
+        m_latitude[id] = p.latitude;
+        m_longitude[id] = p.longitude;
+    }
+
+    void CommitEdge(const Pending& p)
+    {
+        uint32_t u = NodeId(p.source);
+        uint32_t v = NodeId(p.target);
+        if (u == v)
+        {
+            return;
+        }
+        uint64_t rate = p.rate;
+        if (rate == 0 && !p.speed.empty())
+        {
+            ParseRate(p.speed + p.speedUnits, rate);
+        }
+        m_graph->edges.push_back(
+            WanGraph::Edge{u, v, rate ? rate : m_defaultRate, p.delay});
+    }
+
+    /// Resolve delays from coordinates once every node is known.
+    void Finish()
+    {
+        const double pi = 3.14159265358979323846;
+        for (WanGraph::Edge& e : m_graph->edges)
+        {
+            if (e.delayNs != WanGraph::FROM_DISTANCE)
+            {
+                continue;
+            }
+            if (std::isnan(m_latitude[e.u] + m_longitude[e.u] + m_latitude[e.v] +
+                           m_longitude[e.v]))
+            {
+                e.delayNs = m_defaultDelay;
+                continue;
+            }
+            double lat1 = m_latitude[e.u] * pi / 180;
+            double lat2 = m_latitude[e.v] * pi / 180;
+            double dLon = (m_longitude[e.v] - m_longitude[e.u]) * pi / 180;
+            double cosAngle =
+                std::sin(lat1) * std::sin(lat2) + std::cos(lat1) * std::cos(lat2) * std::cos(dLon);
+            double km = 6371.0 * std::acos(std::min(1.0, std::max(-1.0, cosAngle)));
+            // Light in fibre covers about 200 km per ms
+            e.delayNs = std::max<int64_t>(1000, km * 5000);
+        }
+    }
+
+    void ReadEdgeList(std::istream& in)
+    {
+        std::string line;
+        while (std::getline(in, line))
+        {
+            size_t hash = line.find('#');
+            if (hash != std::string::npos)
+            {
+                line.resize(hash);
+            }
+            // Split in place; a stringstream per line would dominate large files
+            std::string fields[4];
+            size_t n = 0;
+            for (size_t pos = line.find_first_not_of(" \t\r"); pos != std::string::npos && n < 4;
+                 ++n)
+            {
+                size_t end = line.find_first_of(" \t\r", pos);
+                fields[n] = line.substr(pos, end - pos);
+                pos = line.find_first_not_of(" \t\r", end);
+            }
+            if (n < 2)
+            {
+                continue;
+            }
+            Pending p;
+            p.source = fields[0];
+            p.target = fields[1];
+            if (n > 2)
+            {
+                ParseRate(fields[2], p.rate);
+            }
+            if (n > 3)
+            {
+                ParseDelay(fields[3], p.delay);
+            }
+            if (p.delay == WanGraph::FROM_DISTANCE)
+            {
+                p.delay = m_defaultDelay;
+            }
+            CommitEdge(p);
+        }
+    }
+
+    /// Value of attribute @p name in a tag, or "".
+    static std::string TagAttribute(const std::string& tag, const std::string& name)
+    {
+        size_t pos = 0;
+        while ((pos = tag.find(name + "=", pos)) != std::string::npos)
+        {
+            if (pos == 0 || tag[pos - 1] == ' ' || tag[pos - 1] == '\t' || tag[pos - 1] == '\n')
+            {
+                char quote = tag[pos + name.size() + 1];
+                size_t begin = pos + name.size() + 2;
+                return tag.substr(begin, tag.find(quote, begin) - begin);
+            }
+            pos += name.size();
+        }
+        return "";
+    }
+
+    void ReadGraphMl(std::istream& in)
+    {
+        std::unordered_map<std::string, std::string> keys; // GraphML key id -> attribute name
+        enum
+        {
+            NONE,
+            NODE,
+            EDGE
+        } element = NONE;
+        Pending p;
+        std::string dataKey;
+        std::string chunk;
+        // Each chunk is "<character data><tag", the '>' being the delimiter
+        while (std::getline(in, chunk, '>'))
+        {
+            size_t open = chunk.rfind('<');
+            if (open == std::string::npos)
+            {
+                continue;
+            }
+            std::string text = chunk.substr(0, open);
+            std::string tag = chunk.substr(open + 1);
+            bool selfClosing = !tag.empty() && tag.back() == '/';
+            std::string name = tag.substr(0, tag.find_first_of(" \t\r\n/", 1));
+            if (name == "key")
+            {
+                keys[TagAttribute(tag, "id")] = TagAttribute(tag, "attr.name");
+            }
+            else if (name == "node")
+            {
+                p = Pending();
+                p.id = TagAttribute(tag, "id");
+                element = NODE;
+                if (selfClosing)
+                {
+                    CommitNode(p);
+                    element = NONE;
+                }
+            }
+            else if (name == "edge")
+            {
+                p = Pending();
+                p.source = TagAttribute(tag, "source");
+                p.target = TagAttribute(tag, "target");
+                element = EDGE;
+                if (selfClosing)
+                {
+                    CommitEdge(p);
+                    element = NONE;
+                }
+            }
+            else if (name == "data")
+            {
+                dataKey = TagAttribute(tag, "key");
+            }
+            else if (name == "/data" && element != NONE)
+            {
+                auto it = keys.find(dataKey);
+                Attribute(p, it == keys.end() ? dataKey : it->second, text);
+            }
+            else if (name == "/node" && element == NODE)
+            {
+                CommitNode(p);
+                element = NONE;
+            }
+            else if (name == "/edge" && element == EDGE)
+            {
+                CommitEdge(p);
+                element = NONE;
+            }
+        }
+    }
+
+    void ReadGml(std::istream& in)
+    {
+        enum
+        {
+            NONE,
+            NODE,
+            EDGE
+        } element = NONE;
+        Pending p;
+        int depth = 0;
+        int elementDepth = 0;
+        std::string key;
+        std::string token;
+        while (in >> token)
+        {
+            if (token[0] == '"' && (token.size() == 1 || token.back() != '"'))
+            {
+                // Quoted value with spaces
+                std::string rest;
+                std::getline(in, rest, '"');
+                token += rest + '"';
+            }
+            if (token == "[")
+            {
+                ++depth;
+                if (key == "node" || key == "edge")
+                {
+                    element = key == "node" ? NODE : EDGE;
+                    elementDepth = depth;
+                    p = Pending();
+                }
+                key.clear();
+                continue;
+            }
+            if (token == "]")
+            {
+                if (element != NONE && depth == elementDepth)
+                {
+                    if (element == NODE)
+                    {
+                        CommitNode(p);
+                    }
+                    else
+                    {
+                        CommitEdge(p);
+                    }
+                    element = NONE;
+                }
+                --depth;
+                continue;
+            }
+            if (key.empty())
+            {
+                key = token;
+                continue;
+            }
+            std::string value =
+                token.size() >= 2 && token[0] == '"' ? token.substr(1, token.size() - 2) : token;
+            if (element != NONE && depth == elementDepth)
+            {
+                if (key == "id")
+                {
+                    p.id = value;
+                }
+                else if (key == "source")
+                {
+                    p.source = value;
+                }
+                else if (key == "target")
+                {
+                    p.target = value;
+                }
+                else
+                {
+                    Attribute(p, key, value);
+                }
+            }
+            key.clear();
+        }
+    }
+
+    uint64_t m_defaultRate;                          //!< Rate when none is given
+    int64_t m_defaultDelay;                          //!< Delay when none can be derived
+    WanGraph* m_graph{nullptr};                      //!< Graph being read
+    std::unordered_map<std::string, uint32_t> m_ids; //!< File node id -> dense id
+    std::vector<double> m_latitude;                  //!< Latitude per node, NaN if unknown
+    std::vector<double> m_longitude;                 //!< Longitude per node, NaN if unknown
+};
+
+/// Nodes and devices built from a WanGraph.
+struct WanTopology
+{
+    NodeContainer nodes;                             //!< One node per graph node
+    std::vector<Ptr<PointToPointNetDevice>> devices; //!< Devices 2e and 2e+1 belong to edge e
+};
+
+/**
+ * @brief Build nodes, links, IPv4 stacks and addresses for a graph in one pass.
+ *
+ * Devices and channels are created directly instead of through
+ * PointToPointHelper, and addresses are set without Ipv4AddressHelper's
+ * global allocation registry: edge e gets 10.0.0.0 + 4e /30, the u end at
+ * .1 and the v end at .2. Up to about 4 million edges fit in 10.0.0.0/8.
+ * MAC addresses are derived from the edge too, so every identifier follows
+ * from the graph alone.
+ *
+ * Nodes are completed one at a time, in id order: stack, then every device
+ * and interface of the node, so a node's objects sit together in memory.
+ * A node's interfaces follow the order of its links in the graph. Graph
+ * scenarios are IPv4-only, so the IPv6 half of the stack is left out.
+ *
+ * ns-3 object creation cannot be spread over threads: reference counts,
+ * including those of shared attribute initial values, are not atomic, and
+ * NodeList, ChannelList and the scheduler are unsynchronised globals.
+ *
+ * @param graph The graph.
+ * @return The topology.
+ */
+inline WanTopology
+BuildWanTopology(const WanGraph& graph)
+{
+    NS_ABORT_MSG_IF(graph.edges.size() >= (1u << 22), "Too many edges for 10.0.0.0/8");
+    const uint32_t n = graph.nodes;
+    std::vector<uint32_t> start(n + 1, 0);
+    for (const WanGraph::Edge& edge : graph.edges)
+    {
+        start[edge.u + 1]++;
+        start[edge.v + 1]++;
+    }
+    for (uint32_t v = 0; v < n; ++v)
+    {
+        start[v + 1] += start[v];
+    }
+    std::vector<uint32_t> ends(start[n]); // Link end 2e + side, grouped by node
+    std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+    for (uint32_t e = 0; e < graph.edges.size(); ++e)
+    {
+        ends[fill[graph.edges[e].u]++] = 2 * e;
+        ends[fill[graph.edges[e].v]++] = 2 * e + 1;
+    }
+
+    WanTopology topology;
+    topology.nodes.Create(n);
+    topology.devices.resize(2 * graph.edges.size());
+    std::vector<Ptr<PointToPointChannel>> channels(graph.edges.size());
+    InternetStackHelper stack;
+    stack.SetIpv6StackInstall(false);
+    const uint32_t base = Ipv4Address("10.0.0.0").Get();
+    const Ipv4Mask mask("255.255.255.252");
+    for (uint32_t v = 0; v < n; ++v)
+    {
+        Ptr<Node> node = topology.nodes.Get(v);
+        stack.Install(node);
+        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+        for (uint32_t i = start[v]; i < start[v + 1]; ++i)
+        {
+            uint32_t end = ends[i];
+            const WanGraph::Edge& edge = graph.edges[end / 2];
+            Ptr<PointToPointChannel>& channel = channels[end / 2];
+            if (!channel)
+            {
+                channel = CreateObject<PointToPointChannel>();
+                channel->SetAttribute("Delay", TimeValue(NanoSeconds(edge.delayNs)));
+            }
+            // Locally administered MAC 02:00 followed by the link end
+            uint8_t mac[6] = {0x02,
+                              0x00,
+                              uint8_t(end >> 24),
+                              uint8_t(end >> 16),
+                              uint8_t(end >> 8),
+                              uint8_t(end)};
+            Mac48Address address;
+            address.CopyFrom(mac);
+            Ptr<PointToPointNetDevice> device = CreateObject<PointToPointNetDevice>();
+            device->SetAddress(address);
+            device->SetDataRate(DataRate(edge.rateBps));
+            device->SetQueue(CreateObject<DropTailQueue<Packet>>());
+            node->AddDevice(device);
+            device->Attach(channel);
+            uint32_t interface = ipv4->AddInterface(device);
+            Ipv4Address local(base + 4 * (end / 2) + 1 + end % 2);
+            ipv4->AddAddress(interface, Ipv4InterfaceAddress(local, mask));
+            ipv4->SetUp(interface);
+            topology.devices[end] = device;
+        }
+    }
+    return topology;
+}
+
+/**
+ * @brief Find the node farthest from node 0 in hops, and a shortest path to it.
+ *
+ * @param graph The graph.
+ * @param[out] path Links of the path, from the farthest node back to node 0.
+ * @return The farthest node, 0 if node 0 has no links.
+ */
+inline uint32_t
+FindFarthestNode(const WanGraph& graph, std::vector<uint32_t>& path)
+{
+    std::vector<std::vector<uint32_t>> adjacency(graph.nodes);
+    for (uint32_t e = 0; e < graph.edges.size(); ++e)
+    {
+        adjacency[graph.edges[e].u].push_back(e);
+        adjacency[graph.edges[e].v].push_back(e);
+    }
+    std::vector<uint32_t> parentEdge(graph.nodes, UINT32_MAX);
+    std::queue<uint32_t> frontier;
+    parentEdge[0] = 0;
+    frontier.push(0);
+    uint32_t farthest = 0;
+    while (!frontier.empty())
+    {
+        uint32_t n = frontier.front();
+        frontier.pop();
+        farthest = n;
+        for (uint32_t e : adjacency[n])
+        {
+            uint32_t m = graph.edges[e].u == n ? graph.edges[e].v : graph.edges[e].u;
+            if (parentEdge[m] == UINT32_MAX)
+            {
+                parentEdge[m] = e;
+                frontier.push(m);
+            }
+        }
+    }
+    path.clear();
+    for (uint32_t n = farthest; n != 0;)
+    {
+        uint32_t e = parentEdge[n];
+        path.push_back(e);
+        n = graph.edges[e].u == n ? graph.edges[e].v : graph.edges[e].u;
+    }
+    return farthest;
+}
+
+/**
+ * @brief Record the arrival time of an echo reply.
+ *
+ * @param log Arrival times.
+ */
+inline void
+LogWanGraphAnswer(std::vector<Time>* log, Ptr<const Packet>)
+{
+    log->push_back(Simulator::Now());
+}
+
+/**
+ * @brief Build a graph and run the primary/backup failover experiment of ex.cc on it.
+ *
+ * Global routing computes the primary paths. Node 0 echoes the node
+ * farthest from it (in hops) ten times a second from 1 s to 8 s; at 4 s the
+ * middle link of the primary path fails and routes are recomputed 50 ms
+ * later, as a fast IGP would. The report gives round trips before and after
+ * the failure and the outage seen by the client.
+ *
+ * Without @p failover only the construction is timed, which suits graphs
+ * too large for global routing's all-pairs route computation.
+ *
+ * The function runs its own simulation, so it must not be called while
+ * another scenario is set up. The caller tears it down, with
+ * Simulator::Destroy() or ExitWithoutTeardown().
+ *
+ * @param graph The graph.
+ * @param failover Route and run the failover experiment after building.
+ * @param os Stream receiving the report.
+ */
+inline void
+RunWanGraphScenario(const WanGraph& graph, bool failover, std::ostream& os)
+{
+    auto begin = std::chrono::steady_clock::now();
+    WanTopology topology = BuildWanTopology(graph);
+    auto built = std::chrono::steady_clock::now();
+    os << "Built " << graph.nodes << " nodes and " << graph.edges.size() << " links in "
+       << std::chrono::duration<double, std::milli>(built - begin).count() << " ms\n";
+    if (!failover)
+    {
+        return;
+    }
+
+    std::vector<uint32_t> path;
+    uint32_t farthest = FindFarthestNode(graph, path);
+    if (farthest == 0)
+    {
+        os << "Node 0 has no neighbours; nothing to fail over\n";
+        return;
+    }
+    uint32_t failed = path[path.size() / 2];
+
+    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    auto routed = std::chrono::steady_clock::now();
+    os << "Global routing: " << std::chrono::duration<double, std::milli>(routed - built).count()
+       << " ms\n";
+
+    Ptr<Node> server = topology.nodes.Get(farthest);
+    Ipv4Address serverAddress = server->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
+    UdpEchoServerHelper echoServer(9);
+    echoServer.Install(server).Start(Seconds(0.5));
+    UdpEchoClientHelper echoClient(serverAddress, 9);
+    echoClient.SetAttribute("MaxPackets", UintegerValue(70));
+    echoClient.SetAttribute("Interval", TimeValue(MilliSeconds(100)));
+    echoClient.SetAttribute("PacketSize", UintegerValue(64));
+    ApplicationContainer client = echoClient.Install(topology.nodes.Get(0));
+    client.Start(Seconds(1.0));
+    std::vector<Time> answers;
+    client.Get(0)->TraceConnectWithoutContext(
+        "Rx",
+        MakeBoundCallback(&LogWanGraphAnswer, &answers));
+
+    for (uint32_t side = 0; side < 2; ++side)
+    {
+        Ptr<NetDevice> device = topology.devices[2 * failed + side];
+        Ptr<Ipv4> ipv4 = device->GetNode()->GetObject<Ipv4>();
+        Simulator::Schedule(Seconds(4.0),
+                            &Ipv4::SetDown,
+                            ipv4,
+                            uint32_t(ipv4->GetInterfaceForDevice(device)));
+    }
+    Simulator::Schedule(Seconds(4.05), &Ipv4GlobalRoutingHelper::RecomputeRoutingTables);
+    Simulator::Stop(Seconds(9.0));
+    Simulator::Run();
+
+    uint32_t before = 0;
+    Time outage;
+    for (size_t i = 0; i < answers.size(); ++i)
+    {
+        before += answers[i] < Seconds(4.0) ? 1 : 0;
+        if (i > 0)
+        {
+            outage = std::max(outage, answers[i] - answers[i - 1]);
+        }
+    }
+    os << "Echo n0 -> n" << farthest << " (" << path.size() << " hops), link "
+       << graph.edges[failed].u << "-" << graph.edges[failed].v << " fails at 4 s\n";
+    os << "Round trips before the failure: " << before << ", after: " << answers.size() - before
+       << " of 70 sent\n";
+    os << "Longest gap between answers: " << outage.As(Time::MS) << "\n";
+}
+
+/**
+ * @brief End the process without tearing the simulation down object by object.
+ *
+ * Simulator::Destroy() disposes and frees every node, device, stack and
+ * route one at a time, which on a large graph can take as long as the run.
+ * Once all reports are written nothing needs that: flushing the output and
+ * leaving with _Exit() returns the whole heap to the system in one step,
+ * without running destructors or static finalisers.
+ *
+ * @param status Exit status.
+ */
+[[noreturn]] inline void
+ExitWithoutTeardown(int status)
+{
+    std::cout.flush();
+    std::cerr.flush();
+    std::_Exit(status);
+}
+
+} // namespace ns3
+
+#endif /* WAN_TOPOLOGY_H */
@@ -0,0 +1,537 @@
+#ifndef WAN_VRF_ROUTING_H
+#define WAN_VRF_ROUTING_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Packet tag selecting the VRF (tenant) a packet is routed in.
+ */
+class VrfTag : public Tag
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::VrfTag").SetParent<Tag>().AddConstructor<VrfTag>();
+        return tid;
+    }
+
+    TypeId GetInstanceTypeId() const override
+    {
+        return GetTypeId();
+    }
+
+    uint32_t GetSerializedSize() const override
+    {
+        return 2;
+    }
+
+    void Serialize(TagBuffer i) const override
+    {
+        i.WriteU16(m_vrf);
+    }
+
+    void Deserialize(TagBuffer i) override
+    {
+        m_vrf = i.ReadU16();
+    }
+
+    void Print(std::ostream& os) const override
+    {
+        os << "vrf=" << m_vrf;
+    }
+
+    /// @param vrf VRF identifier.
+    void SetVrf(uint16_t vrf)
+    {
+        m_vrf = vrf;
+    }
+
+    /// @return The VRF identifier.
+    uint16_t GetVrf() const
+    {
+        return m_vrf;
+    }
+
+  private:
+    uint16_t m_vrf{0}; //!< VRF identifier
+};
+
+/**
+ * @brief Immutable routing table of one VRF.
+ *
+ * Routes are kept in a flat vector sorted by decreasing prefix length and
+ * increasing metric, so the first match of a linear scan is the longest
+ * prefix with the best metric. Tables are interned: identical tables on
+ * different VRFs or routers resolve to the same shared instance.
+ */
+class VrfTable
+{
+  public:
+    /// One route, 12 bytes.
+    struct Entry
+    {
+        uint32_t network;     //!< Destination network address
+        uint32_t gateway;     //!< Next hop (0 for directly connected)
+        uint16_t interface;   //!< Output interface
+        uint8_t prefixLength; //!< Mask length
+        uint8_t metric;       //!< Route metric, lower is preferred
+
+        bool operator==(const Entry& o) const
+        {
+            return network == o.network && gateway == o.gateway && interface == o.interface &&
+                   prefixLength == o.prefixLength && metric == o.metric;
+        }
+    };
+
+    static_assert(sizeof(Entry) == 12, "VrfTable::Entry should pack into 12 bytes");
+
+    /// Shared handle to an interned table.
+    using Handle = std::shared_ptr<const VrfTable>;
+
+    /**
+     * @brief Return the shared instance holding exactly these routes.
+     *
+     * @param entries Routes in any order.
+     * @return The interned table.
+     */
+    static Handle Intern(std::vector<Entry> entries)
+    {
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            if (a.prefixLength != b.prefixLength)
+            {
+                return a.prefixLength > b.prefixLength;
+            }
+            if (a.metric != b.metric)
+            {
+                return a.metric < b.metric;
+            }
+            return a.network < b.network;
+        });
+        uint64_t hash = entries.size();
+        for (const Entry& e : entries)
+        {
+            hash = hash * 0x100000001B3ULL ^ e.network;
+            hash = hash * 0x100000001B3ULL ^ e.gateway;
+            hash = hash * 0x100000001B3ULL ^ (uint64_t(e.interface) << 16 | e.prefixLength << 8 |
+                                              e.metric);
+        }
+
+        std::vector<std::weak_ptr<const VrfTable>>& bucket = Pool()[hash];
+        for (auto it = bucket.begin(); it != bucket.end();)
+        {
+            Handle existing = it->lock();
+            if (!existing)
+            {
+                it = bucket.erase(it);
+                continue;
+            }
+            if (existing->m_entries == entries)
+            {
+                return existing;
+            }
+            ++it;
+        }
+        Handle table(new VrfTable(std::move(entries)));
+        bucket.push_back(table);
+        return table;
+    }
+
+    /**
+     * @brief Return the table extended by one route (copy-on-write).
+     *
+     * @param table Existing table, may be null.
+     * @param entry Route to add.
+     * @return The interned result.
+     */
+    static Handle With(const Handle& table, const Entry& entry)
+    {
+        std::vector<Entry> entries;
+        if (table)
+        {
+            entries = table->m_entries;
+        }
+        entries.push_back(entry);
+        return Intern(std::move(entries));
+    }
+
+    /**
+     * @brief Longest-prefix match skipping routes whose interface is down.
+     *
+     * @param dest Destination address.
+     * @param isUp Returns whether an interface is up.
+     * @return The matching route or null.
+     */
+    const Entry* Lookup(Ipv4Address dest, const std::function<bool(uint32_t)>& isUp) const
+    {
+        uint32_t d = dest.Get();
+        for (const Entry& e : m_entries)
+        {
+            uint32_t mask = e.prefixLength ? ~uint32_t(0) << (32 - e.prefixLength) : 0;
+            if ((d & mask) == e.network && isUp(e.interface))
+            {
+                return &e;
+            }
+        }
+        return nullptr;
+    }
+
+    /// @return The routes in lookup order.
+    const std::vector<Entry>& GetEntries() const
+    {
+        return m_entries;
+    }
+
+    /// @return Number of distinct tables alive.
+    static size_t GetInternedCount()
+    {
+        size_t count = 0;
+        for (const auto& bucket : Pool())
+        {
+            for (const auto& weak : bucket.second)
+            {
+                count += weak.expired() ? 0 : 1;
+            }
+        }
+        return count;
+    }
+
+    /// @return Bytes held by all distinct tables alive.
+    static size_t GetInternedBytes()
+    {
+        size_t bytes = 0;
+        for (const auto& bucket : Pool())
+        {
+            for (const auto& weak : bucket.second)
+            {
+                if (Handle table = weak.lock())
+                {
+                    bytes += sizeof(VrfTable) + table->m_entries.capacity() * sizeof(Entry);
+                }
+            }
+        }
+        return bytes;
+    }
+
+  private:
+    explicit VrfTable(std::vector<Entry> entries)
+        : m_entries(std::move(entries))
+    {
+    }
+
+    static std::unordered_map<uint64_t, std::vector<std::weak_ptr<const VrfTable>>>& Pool()
+    {
+        static std::unordered_map<uint64_t, std::vector<std::weak_ptr<const VrfTable>>> pool;
+        return pool;
+    }
+
+    std::vector<Entry> m_entries; //!< Routes in lookup order
+};
+
+/**
+ * @brief Routing protocol holding one static table per VRF.
+ *
+ * A packet is routed in the VRF bound to its input interface, or else in
+ * the VRF named by its VrfTag. Packets matching neither are left to the
+ * next protocol of the Ipv4ListRouting, which keeps the global table in
+ * Ipv4StaticRouting. Local delivery is handled by Ipv4ListRouting before
+ * this protocol is asked.
+ *
+ * A VRF packet without a route in its VRF is dropped, never left to the
+ * global table. On input that is the error callback. On output a null
+ * route would let Ipv4ListRouting ask the protocols below, so the packet
+ * is routed to the loopback instead: it comes back through RouteInput(),
+ * which drops it, and the drop shows in the Ipv4L3Protocol Drop trace.
+ */
+class Ipv4VrfRouting : public Ipv4RoutingProtocol
+{
+  public:
+    /// VRF id meaning "not bound".
+    static constexpr uint16_t NO_VRF = 0xffff;
+
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::Ipv4VrfRouting")
+                                .SetParent<Ipv4RoutingProtocol>()
+                                .AddConstructor<Ipv4VrfRouting>();
+        return tid;
+    }
+
+    /**
+     * @brief Add a network route to a VRF.
+     *
+     * @param vrf VRF identifier.
+     * @param network Destination network.
+     * @param mask Network mask.
+     * @param nextHop Next hop address.
+     * @param interface Output interface.
+     * @param metric Route metric (0..255).
+     */
+    void AddNetworkRouteTo(uint16_t vrf,
+                           Ipv4Address network,
+                           Ipv4Mask mask,
+                           Ipv4Address nextHop,
+                           uint32_t interface,
+                           uint32_t metric = 0)
+    {
+        if (vrf >= m_tables.size())
+        {
+            m_tables.resize(vrf + 1);
+        }
+        VrfTable::Entry entry{network.CombineMask(mask).Get(),
+                              nextHop.Get(),
+                              uint16_t(interface),
+                              uint8_t(mask.GetPrefixLength()),
+                              uint8_t(std::min<uint32_t>(metric, 255))};
+        m_tables[vrf] = VrfTable::With(m_tables[vrf], entry);
+    }
+
+    /**
+     * @brief Make a VRF share the table of another one (e.g. of another router).
+     *
+     * @param vrf VRF identifier.
+     * @param table Interned table.
+     */
+    void SetTable(uint16_t vrf, VrfTable::Handle table)
+    {
+        if (vrf >= m_tables.size())
+        {
+            m_tables.resize(vrf + 1);
+        }
+        m_tables[vrf] = std::move(table);
+    }
+
+    /**
+     * @param vrf VRF identifier.
+     * @return The table of the VRF, null if it has no routes.
+     */
+    VrfTable::Handle GetTable(uint16_t vrf) const
+    {
+        return vrf < m_tables.size() ? m_tables[vrf] : nullptr;
+    }
+
+    /**
+     * @brief Route everything arriving on an interface in a VRF.
+     *
+     * @param interface Input interface.
+     * @param vrf VRF identifier.
+     */
+    void BindInterface(uint32_t interface, uint16_t vrf)
+    {
+        if (interface >= m_interfaceVrf.size())
+        {
+            m_interfaceVrf.resize(interface + 1, NO_VRF);
+        }
+        m_interfaceVrf[interface] = vrf;
+    }
+
+    /// @return Number of VRFs configured on this router.
+    uint32_t GetNVrfs() const
+    {
+        return m_tables.size();
+    }
+
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                               const Ipv4Header& header,
+                               Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override
+    {
+        VrfTag tag;
+        if (!p || !p->PeekPacketTag(tag))
+        {
+            return nullptr;
+        }
+        Ptr<Ipv4Route> route = Lookup(tag.GetVrf(), header.GetDestination());
+        if (!route)
+        {
+            // Blackhole through the loopback rather than fall through to the global table
+            route = Create<Ipv4Route>();
+            route->SetDestination(header.GetDestination());
+            route->SetGateway(header.GetDestination());
+            route->SetSource(Ipv4Address::GetLoopback());
+            route->SetOutputDevice(m_ipv4->GetNetDevice(0));
+        }
+        sockerr = Socket::ERROR_NOTERROR;
+        return route;
+    }
+
+    bool RouteInput(Ptr<const Packet> p,
+                    const Ipv4Header& header,
+                    Ptr<const NetDevice> idev,
+                    const UnicastForwardCallback& ucb,
+                    const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb,
+                    const ErrorCallback& ecb) override
+    {
+        uint16_t vrf = NO_VRF;
+        uint32_t iif = m_ipv4->GetInterfaceForDevice(idev);
+        if (iif < m_interfaceVrf.size())
+        {
+            vrf = m_interfaceVrf[iif];
+        }
+        VrfTag tag;
+        if (vrf == NO_VRF && p->PeekPacketTag(tag))
+        {
+            vrf = tag.GetVrf();
+        }
+        if (vrf == NO_VRF || header.GetDestination().IsMulticast())
+        {
+            return false;
+        }
+        Ptr<Ipv4Route> route = Lookup(vrf, header.GetDestination());
+        if (!route)
+        {
+            // A tenant packet never leaks into the global table
+            ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+            return true;
+        }
+        ucb(route, p, header);
+        return true;
+    }
+
+    void NotifyInterfaceUp(uint32_t interface) override
+    {
+    }
+
+    void NotifyInterfaceDown(uint32_t interface) override
+    {
+    }
+
+    void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void SetIpv4(Ptr<Ipv4> ipv4) override
+    {
+        m_ipv4 = ipv4;
+    }
+
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+                           Time::Unit unit = Time::S) const override
+    {
+        std::ostream& os = *stream->GetStream();
+        for (uint32_t vrf = 0; vrf < m_tables.size(); ++vrf)
+        {
+            if (!m_tables[vrf])
+            {
+                continue;
+            }
+            os << "VRF " << vrf << " (table " << m_tables[vrf].get() << ")\n";
+            for (const VrfTable::Entry& e : m_tables[vrf]->GetEntries())
+            {
+                os << "  " << Ipv4Address(e.network) << "/" << uint32_t(e.prefixLength) << " via "
+                   << Ipv4Address(e.gateway) << " if " << e.interface << " metric "
+                   << uint32_t(e.metric) << "\n";
+            }
+        }
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_ipv4 = nullptr;
+        m_tables.clear();
+        Ipv4RoutingProtocol::DoDispose();
+    }
+
+  private:
+    Ptr<Ipv4Route> Lookup(uint16_t vrf, Ipv4Address dest) const
+    {
+        if (vrf >= m_tables.size() || !m_tables[vrf])
+        {
+            return nullptr;
+        }
+        const VrfTable::Entry* e = m_tables[vrf]->Lookup(dest, [this](uint32_t i) {
+            return i < m_ipv4->GetNInterfaces() && m_ipv4->IsUp(i);
+        });
+        if (!e)
+        {
+            return nullptr;
+        }
+        Ptr<Ipv4Route> route = Create<Ipv4Route>();
+        route->SetDestination(dest);
+        route->SetGateway(e->gateway ? Ipv4Address(e->gateway) : dest);
+        route->SetOutputDevice(m_ipv4->GetNetDevice(e->interface));
+        route->SetSource(m_ipv4->GetAddress(e->interface, 0).GetLocal());
+        return route;
+    }
+
+    Ptr<Ipv4> m_ipv4;                     //!< IPv4 of the router
+    std::vector<VrfTable::Handle> m_tables;  //!< Interned table per VRF id
+    std::vector<uint16_t> m_interfaceVrf; //!< VRF bound to each input interface
+};
+
+/**
+ * @brief Build an interned VRF table from the current static routes of a node.
+ *
+ * Connected routes are included, so the table can be used on its own.
+ *
+ * @param routing Static routing to copy.
+ * @return The interned table.
+ */
+inline VrfTable::Handle
+SnapshotStaticRoutes(Ptr<Ipv4StaticRouting> routing)
+{
+    std::vector<VrfTable::Entry> entries;
+    entries.reserve(routing->GetNRoutes());
+    for (uint32_t i = 0; i < routing->GetNRoutes(); ++i)
+    {
+        Ipv4RoutingTableEntry route = routing->GetRoute(i);
+        if (route.GetDestNetwork().IsMulticast())
+        {
+            continue;
+        }
+        uint32_t metric = std::min<uint32_t>(routing->GetMetric(i), 255);
+        entries.push_back(VrfTable::Entry{route.GetDestNetwork().Get(),
+                                          route.GetGateway().Get(),
+                                          uint16_t(route.GetInterface()),
+                                          uint8_t(route.GetDestNetworkMask().GetPrefixLength()),
+                                          uint8_t(metric)});
+    }
+    return VrfTable::Intern(std::move(entries));
+}
+
+/**
+ * @brief Add an Ipv4VrfRouting in front of the static routing of a node.
+ *
+ * @param node Node with an installed Internet stack.
+ * @return The VRF routing protocol.
+ */
+inline Ptr<Ipv4VrfRouting>
+InstallVrfRouting(Ptr<Node> node)
+{
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+    Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(ipv4->GetRoutingProtocol());
+    NS_ABORT_MSG_IF(!list, "VRF routing needs the default Ipv4ListRouting");
+    Ptr<Ipv4VrfRouting> vrf = CreateObject<Ipv4VrfRouting>();
+    list->AddRoutingProtocol(vrf, 10);
+    return vrf;
+}
+
+} // namespace ns3
+
+#endif /* WAN_VRF_ROUTING_H */